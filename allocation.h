@@ -0,0 +1,146 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_ALLOCATION_H_
+#define BENCHMARK_ALLOCATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace benchmark {
+
+/* Heap activity through operator new and delete. Counting is opt-in:
+ * define BENCHMARK_TRACK_ALLOCATIONS in exactly one translation unit of the
+ * program before including this header, which replaces the global
+ * allocation functions. Memory obtained with malloc directly, and over-
+ * aligned operator new of C++17, is not seen.
+ */
+struct AllocationCounts {
+  std::uint64_t allocations;
+  std::uint64_t deallocations;
+  std::uint64_t bytes;  // allocated, freed blocks are not subtracted
+
+  AllocationCounts& operator+=(const AllocationCounts& other) {
+    allocations += other.allocations;
+    deallocations += other.deallocations;
+    bytes += other.bytes;
+    return *this;
+  }
+  AllocationCounts operator-(const AllocationCounts& other) const {
+    return AllocationCounts{allocations - other.allocations,
+                            deallocations - other.deallocations,
+                            bytes - other.bytes};
+  }
+};
+
+namespace internal {
+
+/* Running totals of the calling thread.
+ */
+inline AllocationCounts& thread_allocation_counts() {
+  static thread_local AllocationCounts counts = {0, 0, 0};
+  return counts;
+}
+
+inline bool& allocation_tracking_flag() {
+  static bool installed = false;
+  return installed;
+}
+
+inline void* tracked_allocate(std::size_t size) {
+  AllocationCounts& counts = thread_allocation_counts();
+  ++counts.allocations;
+  counts.bytes += size;
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+/* GCC flags the free() once it is inlined into a replaced operator
+ * delete, although the memory did come from malloc.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+inline void tracked_deallocate(void* p) {
+  if (!p) return;
+  ++thread_allocation_counts().deallocations;
+  std::free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+}  // namespace internal
+
+/* Whether the allocation functions of this program are replaced, without
+ * them all counts stay 0.
+ */
+inline bool allocation_tracking_enabled() {
+  return internal::allocation_tracking_flag();
+}
+
+/* Totals of the calling thread since it started, differences of two calls
+ * count the allocations in between.
+ */
+inline AllocationCounts allocation_counts() {
+  return internal::thread_allocation_counts();
+}
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_ALLOCATION_H_
+
+/* Outside the include guard, so the replacement is defined even if the
+ * header was already included without the macro.
+ */
+#if defined(BENCHMARK_TRACK_ALLOCATIONS) && \
+    !defined(BENCHMARK_ALLOCATION_HOOKS_)
+#define BENCHMARK_ALLOCATION_HOOKS_
+
+namespace benchmark {
+namespace internal {
+struct AllocationTrackingInstaller {
+  AllocationTrackingInstaller() { allocation_tracking_flag() = true; }
+};
+static AllocationTrackingInstaller allocation_tracking_installer;
+}  // namespace internal
+}  // namespace benchmark
+
+void* operator new(std::size_t size) {
+  void* p = benchmark::internal::tracked_allocate(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](std::size_t size) {
+  void* p = benchmark::internal::tracked_allocate(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return benchmark::internal::tracked_allocate(size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return benchmark::internal::tracked_allocate(size);
+}
+void operator delete(void* p) noexcept {
+  benchmark::internal::tracked_deallocate(p);
+}
+void operator delete[](void* p) noexcept {
+  benchmark::internal::tracked_deallocate(p);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  benchmark::internal::tracked_deallocate(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  benchmark::internal::tracked_deallocate(p);
+}
+#if __cpp_sized_deallocation >= 201309L
+void operator delete(void* p, std::size_t) noexcept {
+  benchmark::internal::tracked_deallocate(p);
+}
+void operator delete[](void* p, std::size_t) noexcept {
+  benchmark::internal::tracked_deallocate(p);
+}
+#endif
+
+#endif  // BENCHMARK_TRACK_ALLOCATIONS
@@ -0,0 +1,180 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_ASYNC_H_
+#define BENCHMARK_ASYNC_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clock.h"
+#include "error.h"
+#include "time_unit.h"
+
+namespace benchmark {
+
+/* Timer for operations that complete asynchronously, on any thread:
+
+AsyncTimer timer("rpc", 10000, 64);
+while (timer.looping()) {
+  AsyncTimer::Token token = timer.start();
+  pool.submit([token]() mutable { work(); token.complete(); });
+}
+
+looping() blocks while max_outstanding operations are in flight, so 1 gives
+a closed loop that issues the next operation once the previous completed,
+and N keeps N operations in flight. It returns false once all operations
+have completed. Latencies are written lock-free into a slot per operation.
+*/
+class AsyncTimer {
+public:
+  typedef DefaultClock clock_type;
+  typedef clock_type::time_point time_point;
+  typedef std::chrono::nanoseconds duration_type;
+  static constexpr const TimeUnit time_unit = TimeUnit::ns;
+
+  /* Completes one operation. Copies share the operation, and exactly one
+   * of them has to call complete().
+   */
+  class Token {
+  public:
+    Token() : timer_(nullptr), index_(0), start_time_() {}
+
+    void complete() {
+      if (!timer_) {
+        throw BenchmarkError("AsyncTimer::Token::complete: Empty token.");
+      }
+      timer_->complete(index_, start_time_);
+    }
+
+  private:
+    friend class AsyncTimer;
+    Token(AsyncTimer* timer, std::size_t index, time_point start_time) :
+      timer_(timer), index_(index), start_time_(start_time) {}
+
+    AsyncTimer* timer_;
+    std::size_t index_;
+    time_point start_time_;
+  };
+
+  const std::string label;
+
+  AsyncTimer(std::size_t operations = 1, std::size_t max_outstanding = 1) :
+    AsyncTimer("async_timer", operations, max_outstanding) {}
+  AsyncTimer(const std::string& timer_label, std::size_t operations,
+             std::size_t max_outstanding = 1) :
+    label(timer_label),
+    operations_(operations == 0 ? 1 : operations),
+    max_outstanding_(max_outstanding == 0 ? 1 : max_outstanding),
+    started_(0),
+    completed_(0),
+    first_start_(),
+    last_completion_(0),
+    latencies_(operations_) {}
+  AsyncTimer(const AsyncTimer&) = delete;
+  AsyncTimer& operator=(const AsyncTimer&) = delete;
+
+  bool looping() {
+    if (started_ >= operations_) {
+      wait();
+      return false;
+    }
+    while (started_ - completed_.load(std::memory_order_acquire) >=
+           max_outstanding_) {
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+  /* Starts the next operation, once per successful looping().
+   */
+  Token start() {
+    if (started_ >= operations_) {
+      throw BenchmarkError("AsyncTimer::start: All operations started.");
+    }
+    time_point now = clock_type::now();
+    if (started_ == 0) first_start_ = now;
+    return Token(this, started_++, now);
+  }
+
+  /* Blocks until every started operation has completed.
+   */
+  void wait() const {
+    while (completed_.load(std::memory_order_acquire) < started_) {
+      std::this_thread::yield();
+    }
+  }
+
+  void reset(std::size_t operations) {
+    wait();
+    operations_ = operations == 0 ? 1 : operations;
+    started_ = 0;
+    completed_.store(0, std::memory_order_relaxed);
+    last_completion_.store(0, std::memory_order_relaxed);
+    latencies_.assign(operations_, 0);
+  }
+  void reset() { reset(operations_); }
+
+  inline std::size_t operations() const { return operations_; }
+  inline std::size_t max_outstanding() const { return max_outstanding_; }
+  inline std::size_t outstanding() const {
+    return started_ - completed_.load(std::memory_order_acquire);
+  }
+
+  /* Wall time from the first start to the last completion.
+   * Pre-condition: all started operations completed
+   */
+  duration_type duration() const {
+    check_finished("duration");
+    return duration_type(last_completion_.load(std::memory_order_relaxed));
+  }
+  /* Latency of every started operation, in start order.
+   * Pre-condition: all started operations completed
+   */
+  std::vector<duration_type> latencies() const {
+    check_finished("latencies");
+    std::vector<duration_type> res;
+    res.reserve(started_);
+    for (std::size_t i = 0; i < started_; ++i) {
+      res.push_back(duration_type(latencies_[i]));
+    }
+    return res;
+  }
+
+private:
+  void complete(std::size_t index, time_point start_time) {
+    time_point now = clock_type::now_end();
+    latencies_[index] = clock_type::nanoseconds(start_time, now).count();
+    std::int64_t since_first =
+      clock_type::nanoseconds(first_start_, now).count();
+    std::int64_t last = last_completion_.load(std::memory_order_relaxed);
+    while (last < since_first &&
+           !last_completion_.compare_exchange_weak(
+             last, since_first, std::memory_order_relaxed)) {}
+    completed_.fetch_add(1, std::memory_order_release);
+  }
+
+  void check_finished(const std::string& name) const {
+    if (completed_.load(std::memory_order_acquire) != started_) {
+      throw BenchmarkError("AsyncTimer::" + name +
+                           ": Operations are still outstanding.");
+    }
+  }
+
+  std::size_t operations_;
+  std::size_t max_outstanding_;
+  std::size_t started_;  // only touched by the issuing thread
+  std::atomic<std::size_t> completed_;
+  time_point first_start_;
+  std::atomic<std::int64_t> last_completion_;  // ns since first_start_
+  std::vector<std::int64_t> latencies_;  // ns, one slot per operation
+};
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_ASYNC_H_
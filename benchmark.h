@@ -3,38 +3,120 @@
 #define BENCHMARK_BENCHMARK_H_
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <exception>
 #include <functional>
+#include <limits>
+#include <map>
+#include <memory>
 #include <numeric>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "allocation.h"
+#include "async.h"
+#include "cache.h"
+#include "complexity.h"
 #include "error.h"
+#include "histogram.h"
+#include "open_loop.h"
+#include "optimization.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include "statistics.h"
+#include "threading.h"
 #include "timer.h"
 #include "time_unit.h"
 
 namespace benchmark {
 
+class Experiment;
+
+/* Adaptive iteration count. The iteration count grows geometrically until
+ * one run takes at least min_time seconds or the relative standard error
+ * of the mean falls below max_relative_error (0 disables the test). All
+ * runs together are capped at max_time seconds, except the repeat of the
+ * last one for a sample listener or a profiler.
+ */
+struct AutoIterations {
+  TimeValue min_time;
+  TimeValue max_time;
+  double max_relative_error;
+  std::size_t initial_iterations;
+  double growth;
+
+  AutoIterations(TimeValue min_t = 0.5, TimeValue max_t = 10,
+                 double max_rel_err = 0, std::size_t initial_iter = 1,
+                 double growth_factor = 10) :
+    min_time(min_t),
+    max_time(max_t),
+    max_relative_error(max_rel_err),
+    initial_iterations(initial_iter == 0 ? 1 : initial_iter),
+    growth(growth_factor > 1 ? growth_factor : 2) {}
+};
+
 class Benchmark {
 public:
+  friend class Experiment;
+
   struct Result {
     std::string label;
     TimeUnit time_unit;
     std::size_t iterations;
+    /* Of each thread, run before the measured iterations and excluded from
+     * every statistic.
+     */
+    std::size_t warmup_iterations;
     TimeValue duration;
     TimeValue mean;
     TimeValue variance;
     TimeValue max;
     TimeValue min;
+    TimeValue p50;
+    TimeValue p90;
+    TimeValue p99;
+    TimeValue p999;
+    TimeValue median;
+    TimeValue mad;
+    TimeValue iqr;
+    Interval mean_ci;
+    Interval median_ci;
+    Outliers outliers;
+    double cycles;  // mean cycles per iteration, 0 without a cycle counter
+    PerfCounterValues perf_counters;  // per iteration
+    double ipc;
+    std::size_t threads;
+    double ops_per_second;  // iterations of all threads per wall second
+    double complexity_n;  // input size of a parameterized item, 0 otherwise
+    double bytes_per_second;
+    double items_per_second;
+    std::map<std::string, double> counters;  // rates already divided out
+    /* Heap activity per iteration while timed, NaN unless
+     * allocation_tracking_enabled().
+     */
+    double allocations;
+    double deallocations;
+    double allocated_bytes;
+  };
+
+  struct ComplexityResult {
+    std::string label;
+    std::vector<std::size_t> items;
+    ComplexityFit fit;  // of the items' mean time against complexity_n
   };
 
   const std::string label;
 
   Benchmark(const std::string& bm_label = "Benchmark") :
-    label(bm_label), results_() {}
+    label(bm_label), results_(), timers_(), thread_timers_(),
+    thread_results_(), async_timers_(), open_loop_timers_(),
+    complexity_groups_(), profiles_() {}
 
   virtual ~Benchmark() {}
 
@@ -44,8 +126,29 @@ public:
     res.label = label;
     res.time_unit = internal::to_time_unit(unit_symbol);
     res.iterations = timer.iterations();
+    res.warmup_iterations = 0;
+    res.threads = 1;
+    res.complexity_n = 0;
     results_.push_back(res);
     timers_.push_back(timer);
+    thread_timers_.push_back(std::vector<Timer>());
+    thread_results_.push_back(std::vector<Result>());
+    async_timers_.push_back(nullptr);
+    open_loop_timers_.push_back(nullptr);
+    profiles_.push_back(FoldedStacks());
+  }
+  /* Adds an item measured by an AsyncTimer, which the benchmark shares
+   * with whoever drives it.
+   */
+  void add(const std::string& label, const std::string& unit_symbol,
+           const std::shared_ptr<AsyncTimer>& timer) {
+    add(label, unit_symbol, Timer(timer->operations()));
+    async_timers_.back() = timer;
+  }
+  void add(const std::string& label, const std::string& unit_symbol,
+           const std::shared_ptr<OpenLoopTimer>& timer) {
+    add(label, unit_symbol, Timer(timer->operations()));
+    open_loop_timers_.back() = timer;
   }
   void add(const std::vector<std::string>& labels,
            const std::vector<std::string>& unit_symbols,
@@ -63,19 +166,32 @@ public:
     if (index >= results_.size()) {
       throw BenchmarkError("Benchmark::run: Index out of range.");
     }
-    auto durations = timers_[index].durations();
-    TimeUnit timer_time_unit = timers_[index].time_unit, 
-             res_time_unit = results_[index].time_unit;
-    auto to_value = [timer_time_unit, res_time_unit](
-      const typename Timer::duration_type& d) {
-      return internal::convert_time(timer_time_unit, res_time_unit, d.count());
-    };
-    results_[index].duration = to_value(sum(durations));
-    results_[index].mean = to_value(mean(durations));
-    results_[index].variance = to_value(variance(durations));
-    results_[index].max = to_value(max(durations));
-    results_[index].min = to_value(min(durations));
-    return results_[index];    
+    std::vector<const Timer*> timers;
+    std::vector<Result>& thread_results = thread_results_[index];
+    thread_results.clear();
+    if (async_timers_[index]) {
+      collect(results_[index], *async_timers_[index]);
+      return results_[index];
+    }
+    if (open_loop_timers_[index]) {
+      collect(results_[index], *open_loop_timers_[index]);
+      return results_[index];
+    }
+    if (thread_timers_[index].empty()) {
+      timers.push_back(&timers_[index]);
+    } else {
+      for (std::size_t t = 0; t < thread_timers_[index].size(); ++t) {
+        const Timer* timer = &thread_timers_[index][t];
+        timers.push_back(timer);
+        thread_results.push_back(results_[index]);
+        thread_results.back().label =
+          results_[index].label + "/thread:" + std::to_string(t);
+        collect(thread_results.back(),
+                std::vector<const Timer*>(1, timer));
+      }
+    }
+    collect(results_[index], timers);
+    return results_[index];
   }
   virtual const std::vector<Result>& run() {
     for (std::size_t i = 0; i < results_.size(); ++i) {
@@ -94,49 +210,605 @@ public:
     return results_;
   }
 
+  /* Best complexity fit of every group of parameterized items with at
+   * least two distinct input sizes, all of them positive.
+   */
+  std::vector<ComplexityResult> complexity() const {
+    std::vector<ComplexityResult> res;
+    for (const auto& group : complexity_groups_) {
+      std::vector<double> n, time;
+      for (std::size_t index : group.second) {
+        n.push_back(results_[index].complexity_n);
+        time.push_back(results_[index].mean);
+      }
+      if (n.empty() ||
+          std::count(n.begin(), n.end(), n.front()) ==
+          static_cast<std::ptrdiff_t>(n.size()) ||
+          *std::min_element(n.begin(), n.end()) <= 0) {
+        continue;
+      }
+      ComplexityResult c;
+      c.label = group.first;
+      c.items = group.second;
+      c.fit = fit_complexity(n, time);
+      res.push_back(c);
+    }
+    return res;
+  }
+
+  /* Combines repeated runs of one item. Counts and durations add up,
+   * extremes and warmup lengths are taken over all runs, the mean and
+   * variance are pooled, throughput is weighted by duration, user counters
+   * are averaged and order statistics are the median over runs. The
+   * confidence intervals describe the spread of the per-run means and
+   * medians, so they include noise between runs.
+   */
+  static Result aggregate(const std::vector<Result>& repetitions) {
+    if (repetitions.empty()) {
+      throw BenchmarkError("Benchmark::aggregate: No repetitions.");
+    }
+    Result res = repetitions.front();
+    if (repetitions.size() == 1) return res;
+    double n = 0, mean = 0, second_moment = 0, cycles = 0;
+    double allocations = 0, deallocations = 0, allocated_bytes = 0;
+    double bytes = 0, items = 0;
+    std::map<std::string, double> counters;
+    std::vector<double> p50, p90, p99, p999, median, mad, iqr, means;
+    res.iterations = 0;
+    res.duration = 0;
+    res.outliers = Outliers{0, 0, 0, 0};
+    res.perf_counters = PerfCounterValues();
+    for (const Result& r : repetitions) {
+      double w = static_cast<double>(r.iterations);
+      n += w;
+      mean += w * r.mean;
+      second_moment += w * (r.variance + r.mean * r.mean);
+      cycles += w * r.cycles;
+      allocations += w * r.allocations;
+      deallocations += w * r.deallocations;
+      allocated_bytes += w * r.allocated_bytes;
+      res.perf_counters += r.perf_counters * w;
+      res.iterations += r.iterations;
+      res.duration += r.duration;
+      bytes += r.bytes_per_second * r.duration;
+      items += r.items_per_second * r.duration;
+      for (const auto& c : r.counters) counters[c.first] += c.second;
+      res.warmup_iterations =
+        std::max(res.warmup_iterations, r.warmup_iterations);
+      res.max = std::max(res.max, r.max);
+      res.min = std::min(res.min, r.min);
+      res.outliers.low_severe += r.outliers.low_severe;
+      res.outliers.low_mild += r.outliers.low_mild;
+      res.outliers.high_mild += r.outliers.high_mild;
+      res.outliers.high_severe += r.outliers.high_severe;
+      p50.push_back(r.p50);
+      p90.push_back(r.p90);
+      p99.push_back(r.p99);
+      p999.push_back(r.p999);
+      median.push_back(r.median);
+      mad.push_back(r.mad);
+      iqr.push_back(r.iqr);
+      means.push_back(r.mean);
+    }
+    res.mean = mean / n;
+    res.variance = second_moment / n - res.mean * res.mean;
+    res.cycles = cycles / n;
+    res.allocations = allocations / n;
+    res.deallocations = deallocations / n;
+    res.allocated_bytes = allocated_bytes / n;
+    res.perf_counters = res.perf_counters / n;
+    res.ipc = res.perf_counters.ipc();
+    res.p50 = internal::select_median(p50);
+    res.p90 = internal::select_median(p90);
+    res.p99 = internal::select_median(p99);
+    res.p999 = internal::select_median(p999);
+    res.mad = internal::select_median(mad);
+    res.iqr = internal::select_median(iqr);
+    TimeValue seconds = internal::convert_time(res.time_unit, TimeUnit::s,
+                                               res.duration);
+    res.ops_per_second = seconds > 0 ? res.iterations / seconds : 0;
+    res.bytes_per_second = res.duration > 0 ? bytes / res.duration : 0;
+    res.items_per_second = res.duration > 0 ? items / res.duration : 0;
+    for (auto& c : counters) c.second /= repetitions.size();
+    res.counters = counters;
+    Summary over_means = summarize(means), over_medians = summarize(median);
+    res.median = over_medians.median;
+    res.mean_ci = over_means.mean_ci;
+    res.median_ci = over_medians.median_ci;
+    return res;
+  }
+
+  /* Results of the individual threads of a multithreaded item, empty for
+   * items run on a single thread.
+   */
+  const std::vector<Result>& thread_results(std::size_t index) const {
+    if (index >= thread_results_.size()) {
+      throw BenchmarkError("Benchmark::thread_results: Index out of range.");
+    }
+    return thread_results_[index];
+  }
+  /* Folded stacks sampled during the last run of an item, empty unless it
+   * ran with a Profiler.
+   */
+  const FoldedStacks& profile(std::size_t index) const {
+    if (index >= profiles_.size()) {
+      throw BenchmarkError("Benchmark::profile: Index out of range.");
+    }
+    return profiles_[index];
+  }
+
 protected:
   typedef typename Timer::duration_type duration_type;
+  typedef typename Timer::sample_type sample_type;
 
-  duration_type sum(const std::vector<duration_type>& d) {
-    return std::accumulate(d.begin(), d.end(), duration_type(0));
+  /* Fills the measured fields of res from timers that ran concurrently.
+   * Samples of all timers are pooled, iterations add up and the duration
+   * is that of the slowest timer.
+   */
+  void collect(Result& res, const std::vector<const Timer*>& timers) {
+    TimeUnit timer_time_unit = Timer::time_unit,
+             res_time_unit = res.time_unit;
+    auto to_value = [timer_time_unit, res_time_unit](double t) {
+      return internal::convert_time(timer_time_unit, res_time_unit, t);
+    };
+    std::size_t iterations = 0, warmup_iterations = 0;
+    duration_type duration(0);
+    std::uint64_t cycles = 0;
+    PerfCounterValues perf_counters;
+    double bytes = 0, items = 0;
+    std::map<std::string, Counter> counters;
+    AllocationCounts allocations = {0, 0, 0};
+    bool streaming = true;
+    for (const Timer* timer : timers) {
+      iterations += timer->iterations();
+      warmup_iterations =
+        std::max(warmup_iterations, timer->warmup_iterations());
+      bytes += timer->bytes_processed();
+      items += timer->items_processed();
+      for (const auto& c : timer->counters()) {
+        Counter& counter = counters[c.first];
+        counter.value += c.second.value;
+        counter.rate = c.second.rate;
+      }
+      duration = std::max(duration, timer->duration());
+      cycles += timer->cycles();
+      perf_counters += timer->perf_counters();
+      allocations += timer->allocations();
+      streaming = streaming && timer->streaming() &&
+                  timer->statistics().count() != 0;
+    }
+    Summary summary;
+    if (streaming) {
+      StreamingStatistics stats;
+      for (const Timer* timer : timers) stats.merge(timer->statistics());
+      summary = summarize(stats);
+    } else {
+      std::vector<double> samples;
+      for (const Timer* timer : timers) {
+        std::vector<sample_type> durations = timer->durations();
+        for (const sample_type& d : durations) samples.push_back(d.count());
+        if (durations.empty()) samples.push_back(timer->duration().count());
+      }
+      summary = summarize(std::move(samples));
+    }
+    res.iterations = iterations;
+    res.warmup_iterations = warmup_iterations;
+    res.threads = timers.size();
+    res.duration = to_value(duration.count());
+    fill_summary(res, summary);
+    TimeValue seconds = internal::convert_time(
+      timer_time_unit, TimeUnit::s, duration.count());
+    res.ops_per_second = seconds > 0 ? iterations / seconds : 0;
+    res.bytes_per_second = seconds > 0 ? bytes / seconds : 0;
+    res.items_per_second = seconds > 0 ? items / seconds : 0;
+    res.counters.clear();
+    for (const auto& c : counters) {
+      res.counters[c.first] = !c.second.rate ? c.second.value :
+                              seconds > 0 ? c.second.value / seconds : 0;
+    }
+    res.cycles = static_cast<double>(cycles) / iterations;
+    res.perf_counters = perf_counters / iterations;
+    res.ipc = res.perf_counters.ipc();
+    if (allocation_tracking_enabled()) {
+      res.allocations = static_cast<double>(allocations.allocations) /
+                        iterations;
+      res.deallocations = static_cast<double>(allocations.deallocations) /
+                          iterations;
+      res.allocated_bytes = static_cast<double>(allocations.bytes) /
+                            iterations;
+    } else {
+      res.allocations = res.deallocations = res.allocated_bytes =
+        std::numeric_limits<double>::quiet_NaN();
+    }
+  }
+
+  /* Order statistics and intervals of res from a summary of samples in
+   * Timer::time_unit.
+   */
+  void fill_summary(Result& res, const Summary& summary) {
+    TimeUnit timer_time_unit = Timer::time_unit,
+             res_time_unit = res.time_unit;
+    auto to_value = [timer_time_unit, res_time_unit](double t) {
+      return internal::convert_time(timer_time_unit, res_time_unit, t);
+    };
+    res.mean = to_value(summary.mean);
+    res.variance = to_value(to_value(summary.variance));
+    res.max = to_value(summary.max);
+    res.min = to_value(summary.min);
+    res.p50 = to_value(summary.median);
+    res.p90 = to_value(summary.p90);
+    res.p99 = to_value(summary.p99);
+    res.p999 = to_value(summary.p999);
+    res.median = to_value(summary.median);
+    res.mad = to_value(summary.mad);
+    res.iqr = to_value(summary.q3 - summary.q1);
+    res.mean_ci = Interval{to_value(summary.mean_ci.lower),
+                           to_value(summary.mean_ci.upper)};
+    res.median_ci = Interval{to_value(summary.median_ci.lower),
+                             to_value(summary.median_ci.upper)};
+    res.outliers = summary.outliers;
+  }
+
+  /* Fills res from an async run. Samples are operation latencies, the
+   * duration is the wall time of the run and ops_per_second counts
+   * completed operations per second of it.
+   */
+  void collect(Result& res, const AsyncTimer& timer) {
+    std::vector<double> samples;
+    for (const AsyncTimer::duration_type& d : timer.latencies()) {
+      samples.push_back(d.count());
+    }
+    if (samples.empty()) samples.push_back(0);
+    fill_summary(res, summarize(std::move(samples)));
+    TimeValue seconds = internal::convert_time(
+      AsyncTimer::time_unit, TimeUnit::s, timer.duration().count());
+    res.iterations = timer.operations();
+    res.warmup_iterations = 0;
+    res.threads = 1;
+    res.duration = internal::convert_time(
+      AsyncTimer::time_unit, res.time_unit, timer.duration().count());
+    res.ops_per_second = seconds > 0 ? res.iterations / seconds : 0;
+    res.bytes_per_second = 0;
+    res.items_per_second = 0;
+    res.counters.clear();
+    res.cycles = 0;
+    res.perf_counters = PerfCounterValues();
+    res.ipc = res.perf_counters.ipc();
+    res.allocations = res.deallocations = res.allocated_bytes =
+      std::numeric_limits<double>::quiet_NaN();
   }
-  duration_type mean(const std::vector<duration_type>& d) {
+
+  /* Fills res from an open-loop run. Samples are latencies from the
+   * intended start, ops_per_second is the achieved rate and the counters
+   * hold the offered rate and the number of late operations.
+   */
+  void collect(Result& res, const OpenLoopTimer& timer) {
+    fill_summary(res, summarize(timer.statistics()));
+    res.iterations = timer.operations();
+    res.warmup_iterations = 0;
+    res.threads = 1;
+    res.duration = internal::convert_time(
+      OpenLoopTimer::time_unit, res.time_unit, timer.duration().count());
+    res.ops_per_second = timer.achieved_rate();
+    res.bytes_per_second = 0;
+    res.items_per_second = 0;
+    res.counters.clear();
+    res.counters["offered_rate"] = timer.offered_rate();
+    res.counters["late_operations"] = timer.late_operations();
+    res.cycles = 0;
+    res.perf_counters = PerfCounterValues();
+    res.ipc = res.perf_counters.ipc();
+    res.allocations = res.deallocations = res.allocated_bytes =
+      std::numeric_limits<double>::quiet_NaN();
+  }
+
+  /* Runs body(timer) with growing iteration counts until policy is met,
+   * the last run stays in timer. The probes are neither forwarded to the
+   * sample listener of timer nor profiled. With a listener or a profiler,
+   * the chosen count is run once more with them, so that streams and
+   * profile only hold the reported run.
+   */
+  template <typename Body>
+  void run_adaptive(Timer& timer, const AutoIterations& policy, Body body,
+                    Profiler* profiler, FoldedStacks& profile) {
+    SampleListener* listener = timer.sample_listener();
+    std::uint32_t stream = timer.sample_stream();
+    std::size_t iterations = policy.initial_iterations;
+    TimeValue elapsed = 0;
+    while (true) {
+      timer.reset(iterations);
+      timer.set_sample_listener(nullptr, 0);
+      timer.set_profiling(false);
+      body(timer);
+      TimeValue run_time = internal::convert_time(
+        timer.time_unit, TimeUnit::s, timer.duration().count());
+      elapsed += run_time;
+      if (run_time >= policy.min_time || elapsed >= policy.max_time) break;
+      if (policy.max_relative_error > 0 &&
+          relative_standard_error(timer.durations()) <=
+          policy.max_relative_error) {
+        break;
+      }
+      double multiplier = policy.growth;
+      if (run_time > 0) {
+        multiplier = std::min(multiplier, policy.min_time * 1.4 / run_time);
+        multiplier = std::min(multiplier,
+                              (policy.max_time - elapsed) / run_time);
+      }
+      std::size_t next = static_cast<std::size_t>(iterations * multiplier);
+      if (next <= iterations) break;
+      iterations = next;
+    }
+    profile.clear();
+    if (listener || profiler) {
+      timer.reset(iterations);
+      timer.set_sample_listener(listener, stream);
+      run_profiled(timer, profiler, profile, body);
+    }
+  }
+  /* Runs body(timer) under profiler, if any, and moves the stacks to
+   * profile.
+   */
+  template <typename Body>
+  void run_profiled(Timer& timer, Profiler* profiler, FoldedStacks& profile,
+                    Body body) {
+    timer.set_profiling(profiler != nullptr);
+    internal::ProfilerSession session(profiler);
+    body(timer);
+    session.finish(profile);
+  }
+
+  sample_type sum(const std::vector<sample_type>& d) {
+    return std::accumulate(d.begin(), d.end(), sample_type(0));
+  }
+  sample_type mean(const std::vector<sample_type>& d) {
     return sum(d) / d.size();
   }
-  duration_type variance(const std::vector<duration_type>& d) {
-    duration_type mean_d = mean(d);
-    duration_type res(0);
-    for (const duration_type& t : d) {
-      res += duration_type((t - mean_d).count() * (t - mean_d).count());
+  /* Population variance in squared nanoseconds.
+   */
+  double variance(const std::vector<sample_type>& d) {
+    double mean_d = 0, res = 0;
+    for (const sample_type& t : d) mean_d += t.count();
+    mean_d /= d.size();
+    for (const sample_type& t : d) {
+      res += (t.count() - mean_d) * (t.count() - mean_d);
     }
     return res / d.size();
   }
-  duration_type max(const std::vector<duration_type>& d) {
+  double relative_standard_error(const std::vector<sample_type>& d) {
+    if (d.size() < 2) return HUGE_VAL;
+    double m = 0, m2 = 0;
+    for (const sample_type& t : d) m += t.count();
+    m /= d.size();
+    if (m <= 0) return HUGE_VAL;
+    for (const sample_type& t : d) m2 += (t.count() - m) * (t.count() - m);
+    return std::sqrt(m2 / (d.size() - 1) / d.size()) / m;
+  }
+  sample_type max(const std::vector<sample_type>& d) {
     return *std::max_element(d.begin(), d.end());
   }
-  duration_type min(const std::vector<duration_type>& d) {
+  sample_type min(const std::vector<sample_type>& d) {
     return *std::min_element(d.begin(), d.end());
   }
 
   std::vector<Result> results_;
   std::vector<Timer> timers_;
+  std::vector<std::vector<Timer>> thread_timers_;  // empty if single-threaded
+  std::vector<std::vector<Result>> thread_results_;
+  std::vector<std::shared_ptr<AsyncTimer>> async_timers_;  // null if timed
+  std::vector<std::shared_ptr<OpenLoopTimer>> open_loop_timers_;
+  std::vector<std::pair<std::string, std::vector<std::size_t>>>
+    complexity_groups_;
+  std::vector<FoldedStacks> profiles_;
+};
+
+
+namespace internal {
+
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, double>::type
+as_number(const T& value) {
+  return static_cast<double>(value);
+}
+template <typename T>
+typename std::enable_if<!std::is_arithmetic<T>::value, double>::type
+as_number(const T&) {
+  return 0;
+}
+
+template <typename Tuple, bool Empty = std::tuple_size<Tuple>::value == 0>
+struct FirstArgument {
+  static double value(const Tuple& t) { return as_number(std::get<0>(t)); }
+};
+template <typename Tuple>
+struct FirstArgument<Tuple, true> {
+  static double value(const Tuple&) { return 0; }
 };
 
+template <typename Tuple, std::size_t N = 0,
+          bool Finished = N == std::tuple_size<Tuple>::value>
+struct LabelArguments {
+  static void append(std::ostringstream& os, const Tuple& t) {
+    os << "/" << std::get<N>(t);
+    LabelArguments<Tuple, N + 1>::append(os, t);
+  }
+};
+template <typename Tuple, std::size_t N>
+struct LabelArguments<Tuple, N, true> {
+  static void append(std::ostringstream&, const Tuple&) {}
+};
+
+}  // namespace internal
 
 template <typename... Parameters>
 class FunctionBenchmark : public Benchmark {
 public:
   FunctionBenchmark(const std::string& bm_label = "FunctionBenchmark") : 
-    Benchmark(bm_label), functions_(), arguments_() {}
+    Benchmark(bm_label), functions_(), arguments_(), auto_iterations_(),
+    threads_(), affinity_(), perf_counters_(false), listener_(nullptr),
+    warmup_count_(0), auto_warmup_(false, AutoWarmup()),
+    profiler_(nullptr) {}
+
+  /* Counts hardware events of the benchmarked thread in every item run
+   * afterwards, see Timer::set_perf_counters.
+   */
+  void set_perf_counters(bool enable) { perf_counters_ = enable; }
+  /* Forwards the samples of every item run afterwards to listener, each run
+   * as a new stream labelled benchmark/item, see Timer::set_sample_listener.
+   */
+  void set_sample_listener(SampleListener* listener) { listener_ = listener; }
+  /* Samples every item run afterwards with profiler while its timers run,
+   * on all of its threads, and keeps the stacks in profile(). nullptr
+   * stops profiling. The profiler is not owned and has to outlive the
+   * runs. Items run in isolated processes keep no profile.
+   */
+  void set_profiler(Profiler* profiler) { profiler_ = profiler; }
+  /* Warms up every item run afterwards, see Timer::set_warmup. Items on
+   * several threads warm up on each thread.
+   */
+  void set_warmup(std::size_t n) {
+    warmup_count_ = n;
+    auto_warmup_.first = false;
+  }
+  void set_warmup(const AutoWarmup& policy) {
+    auto_warmup_ = std::pair<bool, AutoWarmup>(true, policy);
+  }
 
   template <typename Func, typename... Args>
   void add(const std::string& label, const std::string& unit_symbol,
            std::size_t iterations, Func func, Args&&... args) {
-    functions_.push_back(std::function<void(Timer&, Parameters...)>(func));
-    arguments_.push_back(std::tuple<Parameters...>(args...));
-    Timer timer(iterations);
-    Benchmark::add(label, unit_symbol, timer);
+    add_tuple(label, unit_symbol, iterations, func,
+              std::tuple<Parameters...>(args...));
+  }
+  template <typename Func, typename... Args>
+  void add(const std::string& label, const std::string& unit_symbol,
+           const AutoIterations& iterations, Func func, Args&&... args) {
+    add_tuple(label, unit_symbol, iterations, func,
+              std::tuple<Parameters...>(args...));
   }
+  /* Adds one item per point, labelled label/arg0/arg1/..., and groups them
+   * for Benchmark::complexity() with the first argument as input size.
+   * Points usually come from range() or product(), there must be at least
+   * one and input sizes must be positive.
+   */
+  template <typename Iterations, typename Func>
+  void add_range(const std::string& label, const std::string& unit_symbol,
+                 const Iterations& iterations, Func func,
+                 const std::vector<std::tuple<Parameters...>>& points) {
+    if (points.empty()) {
+      throw BenchmarkError("FunctionBenchmark::add_range: Empty range.");
+    }
+    for (const std::tuple<Parameters...>& point : points) {
+      if (!(internal::FirstArgument<std::tuple<Parameters...>>::value(point) >
+            0)) {
+        throw BenchmarkError("FunctionBenchmark::add_range: "
+                             "Invalid argument.");
+      }
+    }
+    std::vector<std::size_t> items;
+    for (const std::tuple<Parameters...>& point : points) {
+      std::ostringstream point_label;
+      point_label << label;
+      internal::LabelArguments<std::tuple<Parameters...>>::append(
+        point_label, point);
+      add_tuple(point_label.str(), unit_symbol, iterations, func, point);
+      results_.back().complexity_n =
+        internal::FirstArgument<std::tuple<Parameters...>>::value(point);
+      items.push_back(results_.size() - 1);
+    }
+    complexity_groups_.push_back(std::make_pair(label, items));
+  }
+  template <typename Iterations, typename Func, typename T>
+  void add_range(const std::string& label, const std::string& unit_symbol,
+                 const Iterations& iterations, Func func,
+                 const std::vector<T>& values) {
+    std::vector<std::tuple<Parameters...>> points;
+    for (const T& v : values) points.push_back(std::tuple<Parameters...>(v));
+    add_range(label, unit_symbol, iterations, func, points);
+  }
+  /* Adds one item per entry of thread_counts, labelled label/threads:N,
+   * that runs func on N threads at once. Each thread gets its own Timer
+   * with the given iterations and all threads enter func together.
+   */
+  template <typename Func, typename... Args>
+  void add_threaded(const std::string& label, const std::string& unit_symbol,
+                    std::size_t iterations,
+                    const std::vector<std::size_t>& thread_counts,
+                    Func func, Args&&... args) {
+    for (std::size_t n : thread_counts) {
+      if (n == 0) {
+        throw BenchmarkError(
+          "FunctionBenchmark::add_threaded: Thread count must be positive.");
+      }
+      add(label + "/threads:" + std::to_string(n), unit_symbol, iterations,
+          func, args...);
+      threads_.back() = n;
+    }
+  }
+
+  /* Adds the item twice, as label/cache:warm and label/cache:cold, which
+   * shows how much the body depends on a warm cache, see
+   * Timer::set_cache_mode.
+   */
+  template <typename Func, typename... Args>
+  void add_cache_modes(const std::string& label,
+                       const std::string& unit_symbol,
+                       std::size_t iterations, Func func, Args&&... args) {
+    for (CacheMode mode : {CacheMode::warm, CacheMode::cold}) {
+      add(label + "/cache:" + cache_mode_name(mode), unit_symbol, iterations,
+          func, args...);
+      timers_.back().set_cache_mode(mode);
+    }
+  }
+
+  /* Adds an item whose func(AsyncTimer&, args...) issues operations that
+   * complete asynchronously, with at most max_outstanding of them in
+   * flight, see AsyncTimer. The run ends once all operations completed.
+   */
+  template <typename Func, typename... Args>
+  void add_async(const std::string& label, const std::string& unit_symbol,
+                 std::size_t operations, std::size_t max_outstanding,
+                 Func func, Args&&... args) {
+    std::shared_ptr<AsyncTimer> timer =
+      std::make_shared<AsyncTimer>(label, operations, max_outstanding);
+    add(label, unit_symbol, operations,
+        [timer, func](Timer&, Parameters... arguments) {
+          timer->reset();
+          func(*timer, arguments...);
+          timer->wait();
+        }, args...);
+    async_timers_.back() = timer;
+  }
+
+  /* Adds one item per offered rate, labelled label/rate:R, whose
+   * func(OpenLoopTimer&, args...) issues operations on an open-loop
+   * schedule, see OpenLoopTimer. Together the items trace latency against
+   * achieved throughput up to the saturation point.
+   */
+  template <typename Func, typename... Args>
+  void add_open_loop(const std::string& label,
+                     const std::string& unit_symbol,
+                     std::size_t operations, const std::vector<double>& rates,
+                     OpenLoopTimer::Schedule schedule, Func func,
+                     Args&&... args) {
+    for (double rate : rates) {
+      std::ostringstream item_label;
+      item_label << label << "/rate:" << rate;
+      std::shared_ptr<OpenLoopTimer> timer = std::make_shared<OpenLoopTimer>(
+        item_label.str(), operations, rate, schedule);
+      add(item_label.str(), unit_symbol, operations,
+          [timer, func](Timer&, Parameters... arguments) {
+            timer->reset();
+            func(*timer, arguments...);
+          }, args...);
+      open_loop_timers_.back() = timer;
+    }
+  }
+
+  /* Pins thread t of multithreaded items to cpus[t % cpus.size()], an empty
+   * list leaves the threads unpinned.
+   */
+  void set_thread_affinity(const std::vector<int>& cpus) { affinity_ = cpus; }
   template <typename Func, typename... Args>
   void add(const std::vector<std::string>& labels, 
            const std::vector<std::string>& unit_symbols,
@@ -145,8 +817,8 @@ public:
            const std::vector<std::tuple<Args...>>& args) {
     if (labels.size() != unit_symbols.size() ||
         unit_symbols.size() != iterations.size() ||
-        iterations.size() || funcs.size() ||
-        funcs.size() || args.size()) {
+        iterations.size() != funcs.size() ||
+        funcs.size() != args.size()) {
       throw BenchmarkError(
         "FunctionBenchmark::add: Inconsistent sizes.");
     }
@@ -159,7 +831,28 @@ public:
     if (index > results_.size()) {
       throw BenchmarkError("FunctionBenchmark::run: Index of of range.");
     }
-    invoke(functions_[index], timers_[index], arguments_[index]);
+    timers_[index].reset();
+    if (auto_warmup_.first) timers_[index].set_warmup(auto_warmup_.second);
+    else timers_[index].set_warmup(warmup_count_);
+    if (threads_[index] != 0) {
+      run_profiled(timers_[index], profiler_, profiles_[index],
+                   [this, index](Timer&) {
+                     run_threaded(index, threads_[index]);
+                   });
+      return Benchmark::run(index);
+    }
+    if (perf_counters_) timers_[index].set_perf_counters(true);
+    timers_[index].set_sample_listener(listener_, listener_ ?
+      listener_->open_stream(label + "/" + results_[index].label) : 0);
+    auto body = [this, index](Timer& timer) {
+      invoke(functions_[index], timer, arguments_[index]);
+    };
+    if (auto_iterations_[index].first) {
+      run_adaptive(timers_[index], auto_iterations_[index].second, body,
+                   profiler_, profiles_[index]);
+    } else {
+      run_profiled(timers_[index], profiler_, profiles_[index], body);
+    }
     return Benchmark::run(index);
   }
   const std::vector<Result>& run() override {
@@ -170,6 +863,69 @@ public:
   }
 
 private:
+  template <typename Func>
+  void add_tuple(const std::string& label, const std::string& unit_symbol,
+                 std::size_t iterations, Func func,
+                 const std::tuple<Parameters...>& arguments) {
+    functions_.push_back(std::function<void(Timer&, Parameters...)>(func));
+    arguments_.push_back(arguments);
+    auto_iterations_.push_back(std::pair<bool, AutoIterations>(
+      false, AutoIterations()));
+    threads_.push_back(0);
+    Timer timer(iterations);
+    Benchmark::add(label, unit_symbol, timer);
+  }
+  template <typename Func>
+  void add_tuple(const std::string& label, const std::string& unit_symbol,
+                 const AutoIterations& iterations, Func func,
+                 const std::tuple<Parameters...>& arguments) {
+    add_tuple(label, unit_symbol, iterations.initial_iterations, func,
+              arguments);
+    auto_iterations_.back() = std::pair<bool, AutoIterations>(
+      true, iterations);
+  }
+
+  void run_threaded(std::size_t index, std::size_t num_threads) {
+    std::vector<Timer>& timers = thread_timers_[index];
+    timers.clear();
+    for (std::size_t t = 0; t < num_threads; ++t) {
+      timers.push_back(timers_[index]);
+      timers.back().set_sample_listener(listener_, listener_ ?
+        listener_->open_stream(label + "/" + results_[index].label +
+                               "/thread:" + std::to_string(t)) : 0);
+    }
+    internal::Barrier barrier(num_threads);
+    std::vector<std::exception_ptr> errors(num_threads);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < num_threads; ++t) {
+      threads.push_back(std::thread([this, index, t, &timers, &barrier,
+                                     &errors] {
+        if (!affinity_.empty()) {
+          internal::pin_current_thread(
+            std::vector<int>(1, affinity_[t % affinity_.size()]));
+        }
+        timers[t].set_perf_counters(false);
+        if (perf_counters_) timers[t].set_perf_counters(true);
+        timers[t].set_start_barrier(&barrier);
+        barrier.wait();
+        try {
+          invoke(functions_[index], timers[t], arguments_[index]);
+        } catch (...) {
+          errors[t] = std::current_exception();
+        }
+        // A body that never started its timer still releases the others.
+        if (!timers[t].started()) {
+          timers[t].set_start_barrier(nullptr);
+          barrier.wait();
+        }
+      }));
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (const std::exception_ptr& error : errors) {
+      if (error) std::rethrow_exception(error);
+    }
+  }
+
   template <typename Func, typename Tuple, bool Finsihed, int Total, int... N>
   struct InvokeImpl {
     static void invoke(Func func, Timer& timer, Tuple&& t) {
@@ -193,6 +949,14 @@ private:
 
   std::vector<std::function<void(Timer&, Parameters...)>> functions_;
   std::vector<std::tuple<Parameters...>> arguments_;
+  std::vector<std::pair<bool, AutoIterations>> auto_iterations_;
+  std::vector<std::size_t> threads_;  // 0 runs on the calling thread
+  std::vector<int> affinity_;
+  bool perf_counters_;
+  SampleListener* listener_;
+  std::size_t warmup_count_;
+  std::pair<bool, AutoWarmup> auto_warmup_;
+  Profiler* profiler_;
 };
 
 }  // namespace benchmark
@@ -0,0 +1,502 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_BINARY_REPORTER_H_
+#define BENCHMARK_BINARY_REPORTER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "error.h"
+#include "reporter.h"
+#include "serialize.h"
+#include "timer.h"
+#include "time_unit.h"
+
+namespace benchmark {
+
+namespace internal {
+
+/* Appends bytes to a file through a preallocated ring buffer that a
+ * background thread drains. Producers only copy into the ring, the thread
+ * writes whenever half of it is filled or 100 ms have passed, so a
+ * long run reaches the file incrementally. Producers block while the ring
+ * is full.
+ */
+class AsyncFileWriter {
+public:
+  AsyncFileWriter(const std::string& filename, std::size_t capacity) :
+    file_(filename, std::ios::binary | std::ios::trunc),
+    buffer_(capacity == 0 ? 1 : capacity), head_(0), tail_(0),
+    flush_requested_(false), closing_(false), failed_(false),
+    record_mutex_(), mutex_(), data_(), space_(), thread_() {
+    if (!file_.is_open()) {
+      throw BenchmarkError("AsyncFileWriter: Cannot open file \"" +
+                           filename + "\".");
+    }
+    thread_ = std::thread([this] { drain(); });
+  }
+  AsyncFileWriter(const AsyncFileWriter&) = delete;
+  AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+  ~AsyncFileWriter() { close(); }
+
+  /* Appends one record, records of concurrent callers do not interleave.
+   */
+  void write(const char* data, std::size_t size) {
+    std::lock_guard<std::mutex> record_lock(record_mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (size > 0) {
+      space_.wait(lock, [this] {
+        return tail_ - head_ < buffer_.size() || closing_;
+      });
+      if (closing_) {
+        throw BenchmarkError("AsyncFileWriter::write: Writer is closed.");
+      }
+      if (failed_) {
+        throw BenchmarkError("AsyncFileWriter::write: Cannot write file.");
+      }
+      std::size_t pos = tail_ % buffer_.size();
+      std::size_t n = std::min(size, buffer_.size() - (tail_ - head_));
+      n = std::min(n, buffer_.size() - pos);
+      std::memcpy(&buffer_[pos], data, n);
+      tail_ += n;
+      data += n;
+      size -= n;
+      if (tail_ - head_ >= buffer_.size() / 2) data_.notify_one();
+    }
+  }
+
+  /* Blocks until everything written so far has reached the file.
+   */
+  void flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::uint64_t target = tail_;
+    flush_requested_ = true;
+    data_.notify_one();
+    space_.wait(lock, [this, target] { return head_ >= target; });
+    if (failed_) {
+      throw BenchmarkError("AsyncFileWriter::flush: Cannot write file.");
+    }
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (closing_) return;
+      closing_ = true;
+    }
+    data_.notify_one();
+    thread_.join();
+    file_.close();
+  }
+
+private:
+  void drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      data_.wait_for(lock, std::chrono::milliseconds(100), [this] {
+        return closing_ || flush_requested_ ||
+               tail_ - head_ >= buffer_.size() / 2;
+      });
+      std::uint64_t head = head_, tail = tail_;
+      flush_requested_ = false;
+      if (head != tail) {
+        lock.unlock();
+        while (head != tail) {
+          std::size_t pos = head % buffer_.size();
+          std::size_t n = static_cast<std::size_t>(
+            std::min<std::uint64_t>(tail - head, buffer_.size() - pos));
+          file_.write(&buffer_[pos], n);
+          head += n;
+        }
+        file_.flush();
+        lock.lock();
+        if (!file_) failed_ = true;
+        head_ = tail;
+      }
+      space_.notify_all();
+      if (closing_ && head_ == tail_) break;
+    }
+  }
+
+  std::ofstream file_;
+  std::vector<char> buffer_;
+  std::uint64_t head_;  // bytes handed to the file so far
+  std::uint64_t tail_;  // bytes copied into the ring so far
+  bool flush_requested_;
+  bool closing_;
+  bool failed_;
+  std::mutex record_mutex_;
+  std::mutex mutex_;
+  std::condition_variable data_;
+  std::condition_variable space_;
+  std::thread thread_;
+};
+
+/* Every record is a type byte, a 32-bit payload size and the payload in the
+ * native-endian encoding of serialize.h, after an 8 byte file header.
+ */
+enum BinaryRecord : std::uint8_t {
+  stream_record = 1,   // id, label
+  sample_record = 2,   // stream, iteration, batch, ns as double
+  timer_record = 3,    // label, iterations, duration ns, cycles
+  result_record = 4    // benchmark label, Benchmark::Result
+};
+
+inline const char* binary_report_magic() { return "BMREPRT1"; }
+
+inline std::string binary_record(BinaryRecord type,
+                                 const std::string& payload) {
+  std::string res;
+  put(res, static_cast<std::uint8_t>(type));
+  put(res, static_cast<std::uint32_t>(payload.size()));
+  res += payload;
+  return res;
+}
+
+}  // namespace internal
+
+/* Appends raw samples and results to a compact binary file while the run
+ * progresses, through a background writer thread. Attach it to a Timer or
+ * FunctionBenchmark with set_sample_listener, together with streaming mode
+ * so that samples are not kept in memory either. The file is turned into
+ * JSON or CSV by convert_binary_report_to_json and _to_csv.
+ * Samples recorded in a forked child, as with Experiment isolation, are
+ * lost.
+ */
+class BinaryReporter : public FileReporter, public SampleListener {
+public:
+  BinaryReporter(const std::string& filename,
+                 std::size_t buffer_size = 1 << 20) :
+    FileReporter(filename),
+    writer_(new internal::AsyncFileWriter(filename, buffer_size)),
+    num_streams_(0) {
+    writer_->write(internal::binary_report_magic(), 8);
+  }
+
+  using FileReporter::report;
+
+  /* A summary of the timer, its samples are only recorded through the
+   * listener.
+   */
+  void report(const Timer& timer) const override {
+    std::string payload;
+    internal::put(payload, timer.label);
+    internal::put(payload, static_cast<std::uint64_t>(timer.iterations()));
+    internal::put(payload,
+                  static_cast<std::int64_t>(timer.duration().count()));
+    internal::put(payload, static_cast<std::uint64_t>(timer.cycles()));
+    write(internal::timer_record, payload);
+  }
+  void report(const Benchmark& benchmark) const override {
+    for (const Benchmark::Result& result : benchmark.result()) {
+      std::string payload;
+      internal::put(payload, benchmark.label);
+      internal::put(payload, result);
+      write(internal::result_record, payload);
+    }
+  }
+
+  std::uint32_t open_stream(const std::string& label) override {
+    std::uint32_t id = num_streams_++;
+    std::string payload;
+    internal::put(payload, id);
+    internal::put(payload, label);
+    write(internal::stream_record, payload);
+    return id;
+  }
+  void on_sample(std::uint32_t stream, std::uint64_t iteration,
+                 std::uint32_t batch, double ns) override {
+    const std::size_t payload_size = 4 + 8 + 4 + 8;
+    char record[1 + 4 + payload_size];
+    const std::uint8_t type = internal::sample_record;
+    const std::uint32_t size = payload_size;
+    std::memcpy(record, &type, 1);
+    std::memcpy(record + 1, &size, 4);
+    std::memcpy(record + 5, &stream, 4);
+    std::memcpy(record + 9, &iteration, 8);
+    std::memcpy(record + 17, &batch, 4);
+    std::memcpy(record + 21, &ns, 8);
+    writer_->write(record, sizeof(record));
+  }
+
+  void flush() { writer_->flush(); }
+  void close() { writer_->close(); }
+
+private:
+  void write(internal::BinaryRecord type, const std::string& payload) const {
+    std::string record = internal::binary_record(type, payload);
+    writer_->write(record.data(), record.size());
+  }
+
+  std::unique_ptr<internal::AsyncFileWriter> writer_;
+  std::atomic<std::uint32_t> num_streams_;
+};
+
+/* Receives the records of a binary report in file order.
+ */
+class BinaryReportVisitor {
+public:
+  virtual ~BinaryReportVisitor() {}
+  virtual void stream(std::uint32_t /*id*/, const std::string& /*label*/) {}
+  virtual void sample(std::uint32_t /*stream*/, std::uint64_t /*iteration*/,
+                      std::uint32_t /*batch*/, double /*ns*/) {}
+  virtual void timer(const std::string& /*label*/,
+                     std::uint64_t /*iterations*/, std::int64_t /*duration*/,
+                     std::uint64_t /*cycles*/) {}
+  virtual void result(const std::string& /*benchmark*/,
+                      const Benchmark::Result& /*result*/) {}
+};
+
+/* Reads the file one record at a time. A truncated last record, as left by
+ * an interrupted run, ends the report.
+ */
+inline void read_binary_report(const std::string& filename,
+                               BinaryReportVisitor& visitor) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    throw BenchmarkError("read_binary_report: Cannot open file \"" +
+                         filename + "\".");
+  }
+  char magic[8];
+  if (!file.read(magic, 8) ||
+      std::memcmp(magic, internal::binary_report_magic(), 8) != 0) {
+    throw BenchmarkError("read_binary_report: Not a binary report.");
+  }
+  std::string payload;
+  while (true) {
+    char header[5];
+    if (!file.read(header, 5)) break;
+    std::uint8_t type;
+    std::uint32_t size;
+    std::memcpy(&type, header, 1);
+    std::memcpy(&size, header + 1, 4);
+    payload.resize(size);
+    if (size != 0 && !file.read(&payload[0], size)) break;
+    const char* p = payload.data();
+    const char* end = p + payload.size();
+    switch (type) {
+      case internal::stream_record: {
+        std::uint32_t id;
+        std::string label;
+        internal::get(p, end, id);
+        internal::get(p, end, label);
+        visitor.stream(id, label);
+        break;
+      }
+      case internal::sample_record: {
+        std::uint32_t stream, batch;
+        std::uint64_t iteration;
+        double ns;
+        internal::get(p, end, stream);
+        internal::get(p, end, iteration);
+        internal::get(p, end, batch);
+        internal::get(p, end, ns);
+        visitor.sample(stream, iteration, batch, ns);
+        break;
+      }
+      case internal::timer_record: {
+        std::string label;
+        std::uint64_t iterations, cycles;
+        std::int64_t duration;
+        internal::get(p, end, label);
+        internal::get(p, end, iterations);
+        internal::get(p, end, duration);
+        internal::get(p, end, cycles);
+        visitor.timer(label, iterations, duration, cycles);
+        break;
+      }
+      case internal::result_record: {
+        std::string benchmark;
+        Benchmark::Result result;
+        internal::get(p, end, benchmark);
+        internal::get(p, end, result);
+        visitor.result(benchmark, result);
+        break;
+      }
+      default: break;  // unknown records are skipped
+    }
+  }
+}
+
+namespace internal {
+
+inline std::string csv_field(const std::string& s) {
+  if (s.find_first_of(",\"\n") == std::string::npos) return s;
+  std::string res = "\"";
+  for (char c : s) {
+    if (c == '"') res += '"';
+    res += c;
+  }
+  return res + "\"";
+}
+
+/* Samples are written as they are read, streams, timers and results are
+ * few and written at the end. Numbers are written with enough digits to
+ * read back the doubles of the binary report exactly.
+ */
+class JsonConverter : public BinaryReportVisitor {
+public:
+  explicit JsonConverter(std::ostream& out) :
+    out_(out), num_samples_(0), streams_(), timers_(), results_() {
+    out_.precision(std::numeric_limits<double>::max_digits10);
+    out_ << "{\n"
+         << "  \"samples\": [";
+  }
+
+  void stream(std::uint32_t id, const std::string& label) override {
+    streams_.push_back(std::make_pair(id, label));
+  }
+  void sample(std::uint32_t stream, std::uint64_t iteration,
+              std::uint32_t batch, double ns) override {
+    out_ << (num_samples_++ == 0 ? "\n" : ",\n")
+         << "    {\"stream\": " << stream << ", "
+         << "\"iteration\": " << iteration << ", "
+         << "\"batch\": " << batch << ", "
+         << "\"ns\": " << ns << "}";
+  }
+  void timer(const std::string& label, std::uint64_t iterations,
+             std::int64_t duration, std::uint64_t cycles) override {
+    std::ostringstream s;
+    s << "    {\"label\": " << json_string(label) << ", "
+      << "\"iterations\": " << iterations << ", "
+      << "\"duration\": " << duration << ", "
+      << "\"cycles\": " << cycles << "}";
+    timers_.push_back(s.str());
+  }
+  void result(const std::string& benchmark,
+              const Benchmark::Result& result) override {
+    std::ostringstream s;
+    s.precision(std::numeric_limits<double>::max_digits10);
+    s << "    {\n"
+      << "      \"benchmark\": " << json_string(benchmark) << ",\n";
+    write_json_result(s, result, "      ");
+    s << "\n"
+      << "    }";
+    results_.push_back(s.str());
+  }
+
+  void finish() {
+    out_ << (num_samples_ == 0 ? "],\n" : "\n  ],\n")
+         << "  \"streams\": [";
+    for (std::size_t i = 0; i < streams_.size(); ++i) {
+      out_ << (i == 0 ? "\n" : ",\n")
+           << "    {\"id\": " << streams_[i].first << ", "
+           << "\"label\": " << json_string(streams_[i].second) << "}";
+    }
+    out_ << (streams_.empty() ? "],\n" : "\n  ],\n");
+    write_array("timers", timers_);
+    out_ << ",\n";
+    write_array("results", results_);
+    out_ << "\n"
+         << "}\n";
+  }
+
+private:
+  void write_array(const std::string& key,
+                   const std::vector<std::string>& elements) {
+    out_ << "  \"" << key << "\": [";
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+      out_ << (i == 0 ? "\n" : ",\n") << elements[i];
+    }
+    out_ << (elements.empty() ? "]" : "\n  ]");
+  }
+
+  std::ostream& out_;
+  std::size_t num_samples_;
+  std::vector<std::pair<std::uint32_t, std::string>> streams_;
+  std::vector<std::string> timers_;
+  std::vector<std::string> results_;
+};
+
+/* Numbers are written like those of JsonConverter.
+ */
+class CsvConverter : public BinaryReportVisitor {
+public:
+  CsvConverter(std::ostream& samples, std::ostream* results) :
+    samples_(samples), results_(results), labels_() {
+    samples_.precision(std::numeric_limits<double>::max_digits10);
+    samples_ << "stream,label,iteration,batch,ns\n";
+    if (results_) {
+      results_->precision(std::numeric_limits<double>::max_digits10);
+      *results_ << "benchmark,label,time_unit,iterations,warmup_iterations,"
+                   "threads,duration,"
+                   "mean,variance,min,max,median,p90,p99,p999,mad,iqr,"
+                   "mean_ci_lower,mean_ci_upper,median_ci_lower,"
+                   "median_ci_upper,ops_per_second,bytes_per_second,"
+                   "items_per_second,cycles,allocations,deallocations,"
+                   "allocated_bytes\n";
+    }
+  }
+
+  void stream(std::uint32_t id, const std::string& label) override {
+    labels_[id] = csv_field(label);
+  }
+  void sample(std::uint32_t stream, std::uint64_t iteration,
+              std::uint32_t batch, double ns) override {
+    samples_ << stream << "," << labels_[stream] << "," << iteration << ","
+             << batch << "," << ns << "\n";
+  }
+  void result(const std::string& benchmark,
+              const Benchmark::Result& r) override {
+    if (!results_) return;
+    *results_ << csv_field(benchmark) << "," << csv_field(r.label) << ","
+              << time_unit_symbol(r.time_unit) << "," << r.iterations << ","
+              << r.warmup_iterations << "," << r.threads << ","
+              << r.duration << "," << r.mean << ","
+              << r.variance << "," << r.min << "," << r.max << ","
+              << r.median << "," << r.p90 << "," << r.p99 << ","
+              << r.p999 << "," << r.mad << "," << r.iqr << ","
+              << r.mean_ci.lower << "," << r.mean_ci.upper << ","
+              << r.median_ci.lower << "," << r.median_ci.upper << ","
+              << r.ops_per_second << "," << r.bytes_per_second << ","
+              << r.items_per_second << "," << r.cycles << ","
+              << r.allocations << "," << r.deallocations << ","
+              << r.allocated_bytes << "\n";
+  }
+
+private:
+  std::ostream& samples_;
+  std::ostream* results_;
+  std::map<std::uint32_t, std::string> labels_;
+};
+
+}  // namespace internal
+
+/* Writes the binary report as JSON with "samples", "streams", "timers" and
+ * "results" arrays.
+ */
+inline void convert_binary_report_to_json(const std::string& filename,
+                                          std::ostream& out) {
+  internal::JsonConverter converter(out);
+  read_binary_report(filename, converter);
+  converter.finish();
+}
+
+/* Writes one CSV row per sample to samples and, if given, one per result
+ * to results.
+ */
+inline void convert_binary_report_to_csv(const std::string& filename,
+                                         std::ostream& samples,
+                                         std::ostream* results = nullptr) {
+  internal::CsvConverter converter(samples, results);
+  read_binary_report(filename, converter);
+}
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_BINARY_REPORTER_H_
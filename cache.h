@@ -0,0 +1,118 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_CACHE_H_
+#define BENCHMARK_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "optimization.h"
+
+namespace benchmark {
+
+/* Cache state each sample starts from. warm keeps whatever the previous
+ * iteration left behind, cold evicts the last-level cache before every
+ * batch, see Timer::set_cache_mode.
+ */
+enum class CacheMode { warm, cold };
+
+inline std::string cache_mode_name(CacheMode mode) {
+  return mode == CacheMode::cold ? "cold" : "warm";
+}
+
+namespace internal {
+
+/* Size like "32K", "1024K" or "36M" as found in sysfs, 0 if malformed.
+ */
+inline std::size_t parse_cache_size(const std::string& s) {
+  std::size_t res = 0, i = 0;
+  while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+    res = res * 10 + (s[i] - '0');
+    ++i;
+  }
+  if (i == 0) return 0;
+  if (i < s.size()) {
+    if (s[i] == 'K') res <<= 10;
+    else if (s[i] == 'M') res <<= 20;
+    else if (s[i] == 'G') res <<= 30;
+  }
+  return res;
+}
+
+}  // namespace internal
+
+/* Size in bytes of the highest-level data or unified cache of CPU 0, from
+ * /sys/devices/system/cpu, or 0 where that is unavailable.
+ */
+inline std::size_t last_level_cache_size() {
+  std::size_t res = 0;
+  int best_level = 0;
+  for (int index = 0; index < 16; ++index) {
+    std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" +
+                      std::to_string(index) + "/";
+    std::ifstream level_file(dir + "level");
+    std::ifstream type_file(dir + "type");
+    std::ifstream size_file(dir + "size");
+    int level = 0;
+    std::string type, size;
+    if (!level_file.is_open()) break;
+    if (!(level_file >> level) || !(type_file >> type) ||
+        !(size_file >> size)) {
+      continue;
+    }
+    if (type == "Instruction" || level < best_level) continue;
+    best_level = level;
+    res = internal::parse_cache_size(size);
+  }
+  return res;
+}
+
+/* Evicts the caches by reading a buffer twice the size of the last-level
+ * cache, which pushes out every line the benchmark touched, dirty lines
+ * included. The walk only reads, so threads can share one evictor.
+ */
+class CacheEvictor {
+public:
+  static constexpr const std::size_t line_size = 64;
+  static constexpr const std::size_t default_size = 64 << 20;  // bytes
+
+  /* 0 sizes the buffer from last_level_cache_size().
+   */
+  CacheEvictor(std::size_t bytes = 0) : buffer_() {
+    if (bytes == 0) bytes = 2 * last_level_cache_size();
+    if (bytes == 0) bytes = default_size;
+    // Written once so that every page is backed by its own memory.
+    buffer_.assign(bytes / sizeof(std::uint64_t) + 1, 1);
+  }
+
+  inline std::size_t size() const {
+    return buffer_.size() * sizeof(std::uint64_t);
+  }
+
+  void evict() const {
+    const std::size_t stride = line_size / sizeof(std::uint64_t);
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < buffer_.size(); i += stride) sum += buffer_[i];
+    do_not_optimize(sum);
+  }
+
+private:
+  std::vector<std::uint64_t> buffer_;
+};
+
+namespace internal {
+
+/* Shared by all timers in cold mode, allocated on first use.
+ */
+inline const CacheEvictor& cache_evictor() {
+  static const CacheEvictor evictor;
+  return evictor;
+}
+
+}  // namespace internal
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_CACHE_H_
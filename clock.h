@@ -0,0 +1,128 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_CLOCK_H_
+#define BENCHMARK_CLOCK_H_
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define BENCHMARK_HAS_TSC 1
+#endif
+
+#include "error.h"
+
+namespace benchmark {
+namespace internal {
+template <bool IsSteady = std::chrono::high_resolution_clock::is_steady>
+struct SteadyClock {
+  typedef std::chrono::high_resolution_clock type;
+};
+template <>
+struct SteadyClock<false> {
+  typedef std::chrono::steady_clock type;
+};
+}  // namespace internal
+
+/* Clock policies of BasicTimer. A policy provides
+ *   time_point              type of a raw clock reading
+ *   is_cycle_counter        whether readings count CPU cycles
+ *   now()                   reading at the beginning of a timed region
+ *   now_end()               reading at the end of a timed region
+ *   nanoseconds(from, to)   elapsed time between two readings
+ *   cycles(from, to)        elapsed cycles, 0 if not a cycle counter
+ */
+template <typename Clock>
+struct ChronoClock {
+  typedef typename Clock::time_point time_point;
+  static constexpr const bool is_cycle_counter = false;
+
+  static time_point now() { return Clock::now(); }
+  static time_point now_end() { return Clock::now(); }
+  static std::chrono::nanoseconds nanoseconds(const time_point& from,
+                                              const time_point& to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from);
+  }
+  static std::uint64_t cycles(const time_point&, const time_point&) {
+    return 0;
+  }
+};
+
+typedef ChronoClock<internal::SteadyClock<>::type> DefaultClock;
+
+#ifdef BENCHMARK_HAS_TSC
+/* Time stamp counter. Readings are fenced with lfence so that the measured
+ * region can neither start before nor leak past the rdtsc/rdtscp pair.
+ * Conversion to nanoseconds uses a frequency calibrated once per process
+ * against internal::SteadyClock, which is only meaningful if the TSC is
+ * invariant, so calibration throws on a CPU whose TSC is not.
+ */
+struct TscClock {
+  typedef std::uint64_t time_point;
+  static constexpr const bool is_cycle_counter = true;
+
+  static time_point now() {
+    _mm_lfence();
+    time_point t = __rdtsc();
+    _mm_lfence();
+    return t;
+  }
+  static time_point now_end() {
+    unsigned int aux;
+    time_point t = __rdtscp(&aux);
+    _mm_lfence();
+    return t;
+  }
+  static std::chrono::nanoseconds nanoseconds(const time_point& from,
+                                              const time_point& to) {
+    return std::chrono::nanoseconds(static_cast<std::int64_t>(
+      cycles(from, to) / ticks_per_ns() + 0.5));
+  }
+  static std::uint64_t cycles(const time_point& from, const time_point& to) {
+    return to > from ? to - from : 0;
+  }
+
+  /* CPUID.80000007H:EDX[8], constant rate across P-, C- and T-states.
+   */
+  static bool is_invariant() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) ||
+        eax < 0x80000007) {
+      return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+  }
+
+  static double ticks_per_ns() {
+    static const double ratio = calibrate();
+    return ratio;
+  }
+  static double frequency() { return ticks_per_ns() * 1e9; }
+
+  static double calibrate(std::chrono::milliseconds span =
+                            std::chrono::milliseconds(20)) {
+    if (!is_invariant()) {
+      throw BenchmarkError("TscClock::calibrate: "
+                           "The time stamp counter is not invariant.");
+    }
+    typedef internal::SteadyClock<>::type reference_clock;
+    reference_clock::time_point ref_begin = reference_clock::now();
+    time_point tsc_begin = now();
+    reference_clock::time_point ref_end;
+    do {
+      ref_end = reference_clock::now();
+    } while (ref_end - ref_begin < span);
+    time_point tsc_end = now_end();
+    double ns = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        ref_end - ref_begin).count());
+    return static_cast<double>(tsc_end - tsc_begin) / ns;
+  }
+};
+#endif  // BENCHMARK_HAS_TSC
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_CLOCK_H_
@@ -0,0 +1,236 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_COMPARE_H_
+#define BENCHMARK_COMPARE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "error.h"
+#include "json.h"
+#include "statistics.h"
+#include "time_unit.h"
+
+namespace benchmark {
+
+struct ComparisonOptions {
+  /* Relative change below which a difference is not flagged, even if it is
+   * statistically significant.
+   */
+  double threshold;
+  /* Significance level of the Mann-Whitney U test.
+   */
+  double alpha;
+
+  ComparisonOptions(double relative_threshold = 0.05,
+                    double significance = 0.05) :
+    threshold(relative_threshold),
+    alpha(significance) {}
+};
+
+/* One result matched by benchmark and item label across two reports. Times
+ * are in the baseline's time unit, change is relative to the baseline and
+ * positive when the contender is slower.
+ */
+struct Comparison {
+  /* mann_whitney is used when both reports carry raw loop durations,
+   * ci_overlap when they carry median confidence intervals, and no_test
+   * leaves the decision to the threshold alone.
+   */
+  enum Test { no_test, ci_overlap, mann_whitney };
+
+  std::string benchmark;
+  std::string item;
+  TimeUnit time_unit;
+  double baseline;
+  double contender;
+  double change;
+  Test test;
+  double p_value;  // Mann-Whitney U only, NaN otherwise
+  bool significant;
+  bool regression;
+  bool improvement;
+};
+
+namespace internal {
+
+/* Central estimate, optional interval and optional raw samples of one
+ * report entry, as far as the report provides them.
+ */
+struct ReportEntry {
+  TimeUnit time_unit;
+  double estimate;
+  bool has_interval;
+  Interval interval;
+  std::vector<double> samples;
+};
+
+inline double json_to_number(const json::Json& j, const std::string& key) {
+  if (!j.has(key) || !j[key].is_number()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  return j[key].number();
+}
+
+inline std::string json_to_string(const json::Json& j,
+                                  const std::string& key) {
+  if (!j.has(key) || !j[key].is_string()) return "";
+  return j[key].string();
+}
+
+inline void benchmark_entries(
+    const json::Json& bm,
+    std::map<std::pair<std::string, std::string>, ReportEntry>& res) {
+  std::string bm_label = json_to_string(bm, "label");
+  if (!bm.has("item") || !bm["item"].is_array()) {
+    throw BenchmarkError("compare: Benchmark without items.");
+  }
+  const json::Json& items = bm["item"];
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    const json::Json& item = items[i];
+    ReportEntry entry;
+    entry.time_unit = to_time_unit(json_to_string(item, "time_unit"));
+    entry.estimate = json_to_number(item, "median");
+    entry.has_interval = false;
+    if (item.has("median_ci") && item["median_ci"].size() == 2 &&
+        item["median_ci"][0].is_number() &&
+        item["median_ci"][1].is_number()) {
+      entry.has_interval = true;
+      entry.interval = Interval{item["median_ci"][0].number(),
+                                item["median_ci"][1].number()};
+    }
+    res[std::make_pair(bm_label, json_to_string(item, "label"))] = entry;
+  }
+}
+
+/* Timers are keyed by (label, ""), benchmark items by (benchmark label,
+ * item label). Timers report the median of their loop durations and keep
+ * the durations for a rank test; items report their median and its
+ * confidence interval. Experiment reports contribute the items of all
+ * their benchmarks.
+ */
+inline std::map<std::pair<std::string, std::string>, ReportEntry>
+report_entries(const json::Json& report) {
+  std::map<std::pair<std::string, std::string>, ReportEntry> res;
+  if (!report.is_object()) {
+    throw BenchmarkError("compare: Report is not a JSON object.");
+  }
+  if (report.has("Timer")) {
+    const json::Json& timer = report["Timer"];
+    ReportEntry entry;
+    entry.time_unit = to_time_unit(json_to_string(timer, "time_unit"));
+    entry.has_interval = false;
+    if (timer.has("loop_durations") && timer["loop_durations"].is_array()) {
+      const json::Json& durations = timer["loop_durations"];
+      for (std::size_t i = 0; i < durations.size(); ++i) {
+        if (durations[i].is_number()) {
+          entry.samples.push_back(durations[i].number());
+        }
+      }
+    }
+    if (!entry.samples.empty()) {
+      std::vector<double> sorted = entry.samples;
+      std::sort(sorted.begin(), sorted.end());
+      entry.estimate = sorted_quantile(sorted, 0.5);
+    } else {
+      entry.estimate = json_to_number(timer, "duration") /
+                       json_to_number(timer, "iterations");
+    }
+    res[std::make_pair(json_to_string(timer, "label"), std::string())] =
+      entry;
+  }
+  if (report.has("Benchmark")) benchmark_entries(report["Benchmark"], res);
+  if (report.has("Experiment")) {
+    const json::Json& ex = report["Experiment"];
+    if (!ex.has("benchmarks") || !ex["benchmarks"].is_array()) {
+      throw BenchmarkError("compare: Experiment without benchmarks.");
+    }
+    for (std::size_t i = 0; i < ex["benchmarks"].size(); ++i) {
+      benchmark_entries(ex["benchmarks"][i], res);
+    }
+  }
+  return res;
+}
+
+}  // namespace internal
+
+/* Compares every result present in both reports, in label order. Results
+ * found in only one of them are skipped.
+ */
+inline std::vector<Comparison> compare(
+    const json::Json& baseline, const json::Json& contender,
+    const ComparisonOptions& options = ComparisonOptions()) {
+  auto base_entries = internal::report_entries(baseline);
+  auto cont_entries = internal::report_entries(contender);
+  std::vector<Comparison> res;
+  for (const auto& b : base_entries) {
+    auto c = cont_entries.find(b.first);
+    if (c == cont_entries.end()) continue;
+    const internal::ReportEntry& base = b.second;
+    const internal::ReportEntry& cont = c->second;
+    auto convert = [&](double t) {
+      return internal::convert_time(cont.time_unit, base.time_unit, t);
+    };
+    Comparison cmp;
+    cmp.benchmark = b.first.first;
+    cmp.item = b.first.second;
+    cmp.time_unit = base.time_unit;
+    cmp.baseline = base.estimate;
+    cmp.contender = convert(cont.estimate);
+    cmp.change = (cmp.contender - cmp.baseline) / cmp.baseline;
+    cmp.p_value = std::numeric_limits<double>::quiet_NaN();
+    if (!base.samples.empty() && !cont.samples.empty()) {
+      std::vector<double> cont_samples;
+      for (double x : cont.samples) cont_samples.push_back(convert(x));
+      cmp.test = Comparison::mann_whitney;
+      cmp.p_value = mann_whitney_u(base.samples, cont_samples);
+      cmp.significant = cmp.p_value < options.alpha;
+    } else if (base.has_interval && cont.has_interval) {
+      cmp.test = Comparison::ci_overlap;
+      cmp.significant =
+        convert(cont.interval.lower) > base.interval.upper ||
+        convert(cont.interval.upper) < base.interval.lower;
+    } else {
+      cmp.test = Comparison::no_test;
+      cmp.significant = true;
+    }
+    bool valid = std::isfinite(cmp.change);
+    cmp.regression = valid && cmp.significant &&
+                     cmp.change > options.threshold;
+    cmp.improvement = valid && cmp.significant &&
+                      cmp.change < -options.threshold;
+    res.push_back(cmp);
+  }
+  return res;
+}
+
+/* Reads a report written by JsonReporter.
+ */
+inline json::Json read_report(const std::string& filename) {
+  std::ifstream file(filename);
+  if (!file.is_open()) {
+    throw BenchmarkError("read_report: Cannot open file \"" + filename +
+                         "\".");
+  }
+  std::string content((std::istreambuf_iterator<char>(file)),
+                      std::istreambuf_iterator<char>());
+  return json::parse(content);
+}
+
+inline std::vector<Comparison> compare(
+    const std::string& baseline_file, const std::string& contender_file,
+    const ComparisonOptions& options = ComparisonOptions()) {
+  return compare(read_report(baseline_file), read_report(contender_file),
+                 options);
+}
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_COMPARE_H_
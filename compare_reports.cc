@@ -0,0 +1,81 @@
+/* 2026-10-18 */
+/*
+
+Compares two reports written by JsonReporter:
+
+  compare_reports baseline.json contender.json [threshold] [alpha]
+
+threshold is the relative slowdown that counts as a regression (default
+0.05), alpha the significance level of the rank test (default 0.05). Exits
+with 1 if any result regressed significantly, 2 on errors and 0 otherwise,
+so it can gate a deployment.
+
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "compare.h"
+
+using namespace benchmark;
+
+namespace {
+
+const char* test_name(Comparison::Test test) {
+  switch (test) {
+    case Comparison::ci_overlap: return "ci"; break;
+    case Comparison::mann_whitney: return "u-test"; break;
+    default: return "none";
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 3 || argc > 5) {
+    std::fprintf(stderr, "Usage: %s baseline.json contender.json "
+                         "[threshold] [alpha]\n", argv[0]);
+    return 2;
+  }
+  ComparisonOptions options;
+  if (argc > 3) options.threshold = std::atof(argv[3]);
+  if (argc > 4) options.alpha = std::atof(argv[4]);
+
+  std::vector<Comparison> comparisons;
+  try {
+    comparisons = compare(std::string(argv[1]), std::string(argv[2]),
+                          options);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 2;
+  }
+
+  std::size_t regressions = 0;
+  std::printf("%-40s %14s %14s %9s %7s %9s\n", "benchmark/item",
+              "baseline", "contender", "change", "test", "p");
+  for (const Comparison& cmp : comparisons) {
+    std::string name = cmp.item.empty() ? cmp.benchmark :
+                       cmp.benchmark + "/" + cmp.item;
+    std::string unit = internal::time_unit_symbol(cmp.time_unit);
+    const char* verdict = cmp.regression ? "REGRESSION" :
+                          cmp.improvement ? "improvement" : "";
+    std::printf("%-40s %11.4g %-2s %11.4g %-2s %+8.2f%% %7s ",
+                name.c_str(), cmp.baseline, unit.c_str(),
+                cmp.contender, unit.c_str(), cmp.change * 100,
+                test_name(cmp.test));
+    if (std::isnan(cmp.p_value)) std::printf("%9s", "-");
+    else std::printf("%9.3g", cmp.p_value);
+    std::printf(" %s\n", verdict);
+    if (cmp.regression) ++regressions;
+  }
+  if (regressions != 0) {
+    std::printf("%zu of %zu results regressed by more than %g%%.\n",
+                regressions, comparisons.size(), options.threshold * 100);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_COMPLEXITY_H_
+#define BENCHMARK_COMPLEXITY_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "error.h"
+
+namespace benchmark {
+
+enum BigO { O1, OLogN, ON, ONLogN, ON2, num_big_o };
+
+struct ComplexityFit {
+  BigO complexity;
+  double coefficient;  // time ~ coefficient * f(n)
+  double rms;          // root mean square residual relative to mean time
+};
+
+namespace internal {
+
+inline std::string big_o_symbol(BigO complexity) {
+  switch (complexity) {
+    case O1: return "O(1)"; break;
+    case OLogN: return "O(log N)"; break;
+    case ON: return "O(N)"; break;
+    case ONLogN: return "O(N log N)"; break;
+    case ON2: return "O(N^2)"; break;
+    default: return "unknown";
+  }
+}
+
+inline double big_o_value(BigO complexity, double n) {
+  switch (complexity) {
+    case O1: return 1; break;
+    case OLogN: return std::log2(n); break;
+    case ON: return n; break;
+    case ONLogN: return n * std::log2(n); break;
+    case ON2: return n * n; break;
+    default: return 0;
+  }
+}
+
+}  // namespace internal
+
+/* Least-squares fit of time = coefficient * f(n) for one complexity class.
+ * Input sizes must be positive, log2 has no value at 0.
+ */
+inline ComplexityFit fit_complexity(const std::vector<double>& n,
+                                    const std::vector<double>& time,
+                                    BigO complexity) {
+  if (n.size() != time.size() || n.empty()) {
+    throw BenchmarkError("fit_complexity: Inconsistent sizes.");
+  }
+  for (double size : n) {
+    if (!(size > 0)) {
+      throw BenchmarkError("fit_complexity: Invalid argument.");
+    }
+  }
+  double ft = 0, ff = 0, mean = 0;
+  for (std::size_t i = 0; i < n.size(); ++i) {
+    double f = internal::big_o_value(complexity, n[i]);
+    ft += f * time[i];
+    ff += f * f;
+    mean += time[i];
+  }
+  mean /= n.size();
+  ComplexityFit fit;
+  fit.complexity = complexity;
+  fit.coefficient = ff > 0 ? ft / ff : 0;
+  double residual = 0;
+  for (std::size_t i = 0; i < n.size(); ++i) {
+    double r = time[i] -
+               fit.coefficient * internal::big_o_value(complexity, n[i]);
+    residual += r * r;
+  }
+  fit.rms = mean > 0 ? std::sqrt(residual / n.size()) / mean : 0;
+  return fit;
+}
+
+/* Best fitting complexity class, the one with the smallest residual.
+ */
+inline ComplexityFit fit_complexity(const std::vector<double>& n,
+                                    const std::vector<double>& time) {
+  if (n.size() < 2) {
+    throw BenchmarkError("fit_complexity: At least two points are needed.");
+  }
+  ComplexityFit best = fit_complexity(n, time, O1);
+  for (int c = OLogN; c < num_big_o; ++c) {
+    ComplexityFit fit = fit_complexity(n, time, static_cast<BigO>(c));
+    if (fit.rms < best.rms) best = fit;
+  }
+  return best;
+}
+
+/* lo, lo * multiplier, lo * multiplier^2, ... up to and including hi.
+ */
+inline std::vector<std::int64_t> range(std::int64_t lo, std::int64_t hi,
+                                       std::int64_t multiplier = 8) {
+  if (lo > hi || multiplier < 2) {
+    throw BenchmarkError("range: Invalid bounds or multiplier.");
+  }
+  std::vector<std::int64_t> res;
+  for (std::int64_t v = lo; v < hi;) {
+    res.push_back(v);
+    if (v > std::numeric_limits<std::int64_t>::max() / multiplier) break;
+    v = v <= 0 ? 1 : v * multiplier;
+  }
+  res.push_back(hi);
+  return res;
+}
+
+/* Cartesian product of argument lists, with the last list varying fastest.
+ */
+inline std::vector<std::tuple<>> product() {
+  return std::vector<std::tuple<>>(1);
+}
+template <typename T, typename... Ts>
+std::vector<std::tuple<T, Ts...>> product(const std::vector<T>& head,
+                                          const std::vector<Ts>&... tail) {
+  std::vector<std::tuple<Ts...>> rest = product(tail...);
+  std::vector<std::tuple<T, Ts...>> res;
+  res.reserve(head.size() * rest.size());
+  for (const T& h : head) {
+    for (const std::tuple<Ts...>& r : rest) {
+      res.push_back(std::tuple_cat(std::make_tuple(h), r));
+    }
+  }
+  return res;
+}
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_COMPLEXITY_H_
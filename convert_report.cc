@@ -0,0 +1,63 @@
+/* 2026-10-18 */
+/*
+
+Converts a report written by BinaryReporter:
+
+  convert_report report.bin json [report.json]
+  convert_report report.bin csv samples.csv [results.csv]
+
+JSON goes to standard output unless a file is given.
+
+*/
+
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "binary_reporter.h"
+
+using namespace benchmark;
+
+int main(int argc, char* argv[]) {
+  std::string format = argc > 2 ? argv[2] : "";
+  if ((format != "json" || argc > 4) &&
+      (format != "csv" || argc < 4 || argc > 5)) {
+    std::fprintf(stderr, "Usage: %s report.bin json [report.json]\n"
+                         "       %s report.bin csv samples.csv "
+                         "[results.csv]\n", argv[0], argv[0]);
+    return 2;
+  }
+  try {
+    if (format == "json") {
+      if (argc == 4) {
+        std::ofstream out(argv[3]);
+        if (!out.is_open()) {
+          throw BenchmarkError(std::string("Cannot open file ") + argv[3]);
+        }
+        convert_binary_report_to_json(argv[1], out);
+      } else {
+        convert_binary_report_to_json(argv[1], std::cout);
+      }
+    } else {
+      std::ofstream samples(argv[3]);
+      std::ofstream results;
+      if (!samples.is_open()) {
+        throw BenchmarkError(std::string("Cannot open file ") + argv[3]);
+      }
+      if (argc == 5) {
+        results.open(argv[4]);
+        if (!results.is_open()) {
+          throw BenchmarkError(std::string("Cannot open file ") + argv[4]);
+        }
+      }
+      convert_binary_report_to_csv(argv[1], samples,
+                                   argc == 5 ? &results : nullptr);
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -13,35 +13,324 @@ EX_sort.report(json_reporter);
 #ifndef BENCHMARK_EXPERIMENT_H_
 #define BENCHMARK_EXPERIMENT_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <random>
 #include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define BENCHMARK_HAS_FORK 1
+#endif
+
 #include "benchmark.h"
+#include "error.h"
+#include "serialize.h"
+#include "statistics.h"
+#include "threading.h"
 
 namespace benchmark {
 
 class Experiment {
 public:
+  /* none runs every benchmark in this process. per_benchmark forks one
+   * child per benchmark that runs all of its repetitions, per_repetition
+   * forks one child per repetition. Children send their results back
+   * over a pipe.
+   */
+  enum Isolation { none, per_benchmark, per_repetition };
+  /* sequential runs all repetitions of one benchmark before the next.
+   * interleaved runs the repetitions in rounds, each running every item of
+   * every benchmark once in an order shuffled with the seed, so drift such
+   * as throttling or background load is spread over all items instead of
+   * biasing whichever ran last. It requires isolation none.
+   */
+  enum Order { sequential, interleaved };
+
   const std::string label;
 
-  Experiment(const std::string& ex_label) : 
-    label(ex_label), benchmarks_(), reporter_() { initialize(); }
+  Experiment(const std::string& ex_label) :
+    label(ex_label), benchmarks_(), isolation_(none), order_(sequential),
+    seed_(5489u), repetitions_(1), warmup_(0), cpus_(), repetition_results_() {
+    initialize();
+  }
   virtual ~Experiment() { finialize(); }
 
-  virtual void add(const Benchmark& benchmark) {
+  /* The benchmark is run in place, so it has to outlive the experiment.
+   */
+  virtual void add(Benchmark& benchmark) {
     benchmarks_.push_back(&benchmark);
+    repetition_results_.push_back(
+      std::vector<std::vector<Benchmark::Result>>());
+  }
+  virtual void add(
+    std::initializer_list<std::reference_wrapper<Benchmark>> list) {
+    for (Benchmark& benchmark : list) add(benchmark);
+  }
+
+  void set_isolation(Isolation mode) {
+#ifndef BENCHMARK_HAS_FORK
+    if (mode != none) {
+      throw BenchmarkError("Experiment::set_isolation: "
+                           "Process isolation is not supported.");
+    }
+#endif
+    isolation_ = mode;
   }
+  /* Each benchmark is run n times and its results are aggregated with
+   * Benchmark::aggregate.
+   */
+  void set_repetitions(std::size_t n) { repetitions_ = n == 0 ? 1 : n; }
+  /* Each benchmark is run n more times before its first repetition, in the
+   * process that measures it, and those results are discarded.
+   */
+  void set_warmup(std::size_t n) { warmup_ = n; }
+  void set_order(Order order, std::uint64_t seed = 5489u) {
+    order_ = order;
+    seed_ = seed;
+  }
+  /* CPUs isolated children are pinned to, empty for no pinning.
+   */
+  void set_cpu_affinity(const std::vector<int>& cpus) { cpus_ = cpus; }
+
   virtual void run() {
-  	for (Benchmark* bm : benchmarks_) {
-  		bm->run();
-  	}
+    if (order_ == interleaved) {
+      run_interleaved();
+      return;
+    }
+    for (std::size_t i = 0; i < benchmarks_.size(); ++i) {
+      run_benchmark(i);
+    }
+  }
+
+  inline std::size_t size() const { return benchmarks_.size(); }
+  const Benchmark& benchmark(std::size_t index) const {
+    if (index >= benchmarks_.size()) {
+      throw BenchmarkError("Experiment::benchmark: Index out of range.");
+    }
+    return *benchmarks_[index];
+  }
+  Benchmark& benchmark(std::size_t index) {
+    if (index >= benchmarks_.size()) {
+      throw BenchmarkError("Experiment::benchmark: Index out of range.");
+    }
+    return *benchmarks_[index];
+  }
+  /* Results of every repetition of a benchmark, indexed by repetition and
+   * then by item.
+   */
+  const std::vector<std::vector<Benchmark::Result>>&
+  repetition_results(std::size_t index) const {
+    if (index >= repetition_results_.size()) {
+      throw BenchmarkError(
+        "Experiment::repetition_results: Index out of range.");
+    }
+    return repetition_results_[index];
+  }
+
+  /* Paired difference of item_b of benchmark b against item_a of
+   * benchmark a, pairing the medians of the same repetition, in the time
+   * unit of item_a. Most useful with interleaved order, where both ran in
+   * the same rounds.
+   */
+  PairedDifference compare(std::size_t a, std::size_t item_a,
+                           std::size_t b, std::size_t item_b,
+                           double confidence = 0.95) const {
+    const std::vector<std::vector<Benchmark::Result>>& runs_a =
+      repetition_results(a);
+    const std::vector<std::vector<Benchmark::Result>>& runs_b =
+      repetition_results(b);
+    std::vector<double> medians_a, medians_b;
+    for (std::size_t r = 0; r < runs_a.size() && r < runs_b.size(); ++r) {
+      if (item_a >= runs_a[r].size() || item_b >= runs_b[r].size()) {
+        throw BenchmarkError("Experiment::compare: Index out of range.");
+      }
+      const Benchmark::Result& result_a = runs_a[r][item_a];
+      const Benchmark::Result& result_b = runs_b[r][item_b];
+      medians_a.push_back(result_a.median);
+      medians_b.push_back(internal::convert_time(
+        result_b.time_unit, result_a.time_unit, result_b.median));
+    }
+    return paired_difference(medians_a, medians_b, confidence);
   }
 
 protected:
   virtual void initialize() {}
   virtual void finialize() {}
 
+  void run_benchmark(std::size_t index) {
+    Benchmark* bm = benchmarks_[index];
+    std::vector<std::vector<Benchmark::Result>>& repetitions =
+      repetition_results_[index];
+    repetitions.clear();
+    if (isolation_ == per_benchmark) {
+      repetitions = run_isolated(bm, repetitions_);
+    } else {
+      if (isolation_ == none) warm_up(bm);
+      for (std::size_t r = 0; r < repetitions_; ++r) {
+        if (isolation_ == per_repetition) {
+          repetitions.push_back(run_isolated(bm, 1).front());
+        } else {
+          repetitions.push_back(bm->run());
+        }
+      }
+    }
+    aggregate_repetitions(index);
+  }
+
+  void warm_up(Benchmark* bm) {
+    for (std::size_t w = 0; w < warmup_; ++w) bm->run();
+  }
+
+  void run_interleaved() {
+    if (isolation_ != none) {
+      throw BenchmarkError("Experiment::run: "
+                           "Interleaved order requires isolation none.");
+    }
+    std::vector<std::pair<std::size_t, std::size_t>> units;
+    for (std::size_t i = 0; i < benchmarks_.size(); ++i) {
+      repetition_results_[i].assign(repetitions_, benchmarks_[i]->results_);
+      for (std::size_t item = 0; item < benchmarks_[i]->results_.size();
+           ++item) {
+        units.push_back(std::make_pair(i, item));
+      }
+    }
+    for (Benchmark* bm : benchmarks_) warm_up(bm);
+    std::mt19937_64 rng(seed_);
+    for (std::size_t r = 0; r < repetitions_; ++r) {
+      std::shuffle(units.begin(), units.end(), rng);
+      for (const auto& unit : units) {
+        repetition_results_[unit.first][r][unit.second] =
+          benchmarks_[unit.first]->run(unit.second);
+      }
+    }
+    for (std::size_t i = 0; i < benchmarks_.size(); ++i) {
+      aggregate_repetitions(i);
+    }
+  }
+
+  void aggregate_repetitions(std::size_t index) {
+    Benchmark* bm = benchmarks_[index];
+    const std::vector<std::vector<Benchmark::Result>>& repetitions =
+      repetition_results_[index];
+    for (std::size_t item = 0; item < bm->results_.size(); ++item) {
+      std::vector<Benchmark::Result> runs;
+      for (const std::vector<Benchmark::Result>& results : repetitions) {
+        if (item < results.size()) runs.push_back(results[item]);
+      }
+      if (!runs.empty()) bm->results_[item] = Benchmark::aggregate(runs);
+    }
+  }
+
+  std::vector<std::vector<Benchmark::Result>>
+  run_isolated(Benchmark* bm, std::size_t repetitions) {
+    std::vector<std::vector<Benchmark::Result>> res;
+#ifdef BENCHMARK_HAS_FORK
+    int fds[2];
+    if (pipe(fds) != 0) {
+      throw BenchmarkError("Experiment::run: Cannot create pipe.");
+    }
+    std::fflush(nullptr);
+    pid_t pid = fork();
+    if (pid < 0) {
+      close(fds[0]);
+      close(fds[1]);
+      throw BenchmarkError("Experiment::run: Cannot fork.");
+    }
+    if (pid == 0) {
+      close(fds[0]);
+      std::string out;
+      try {
+        if (!cpus_.empty()) internal::pin_current_process(cpus_);
+        internal::put(out, static_cast<std::uint8_t>(1));
+        warm_up(bm);
+        internal::put(out, static_cast<std::uint64_t>(repetitions));
+        for (std::size_t r = 0; r < repetitions; ++r) {
+          const std::vector<Benchmark::Result>& results = bm->run();
+          internal::put(out, static_cast<std::uint64_t>(results.size()));
+          for (const Benchmark::Result& result : results) {
+            internal::put(out, result);
+          }
+        }
+      } catch (const std::exception& e) {
+        out.clear();
+        internal::put(out, static_cast<std::uint8_t>(0));
+        internal::put(out, std::string(e.what()));
+      }
+      const char* p = out.data();
+      std::size_t left = out.size();
+      while (left > 0) {
+        ssize_t n = write(fds[1], p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) _exit(1);
+        p += n;
+        left -= n;
+      }
+      _exit(0);
+    }
+    close(fds[1]);
+    std::string in;
+    char buf[4096];
+    while (true) {
+      ssize_t n = read(fds[0], buf, sizeof(buf));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) break;
+      in.append(buf, n);
+    }
+    close(fds[0]);
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      throw BenchmarkError("Experiment::run: Isolated benchmark \"" +
+                           bm->label + "\" terminated abnormally.");
+    }
+    const char* p = in.data();
+    const char* end = p + in.size();
+    std::uint8_t ok;
+    internal::get(p, end, ok);
+    if (!ok) {
+      std::string message;
+      internal::get(p, end, message);
+      throw BenchmarkError("Experiment::run: " + message);
+    }
+    std::uint64_t num_repetitions, num_results;
+    internal::get(p, end, num_repetitions);
+    for (std::uint64_t r = 0; r < num_repetitions; ++r) {
+      internal::get(p, end, num_results);
+      res.push_back(std::vector<Benchmark::Result>(num_results));
+      for (Benchmark::Result& result : res.back()) {
+        internal::get(p, end, result);
+      }
+    }
+#else
+    (void)bm;
+    (void)repetitions;
+    throw BenchmarkError("Experiment::run: "
+                         "Process isolation is not supported.");
+#endif
+    return res;
+  }
+
   std::vector<Benchmark*> benchmarks_;
+  Isolation isolation_;
+  Order order_;
+  std::uint64_t seed_;
+  std::size_t repetitions_;
+  std::size_t warmup_;
+  std::vector<int> cpus_;
+  std::vector<std::vector<std::vector<Benchmark::Result>>> repetition_results_;
 };
 
 }  // namespace benchmark
 
-#endif  // BENCHMARK_EXPERIMENT_H_
\ No newline at end of file
+#endif  // BENCHMARK_EXPERIMENT_H_
@@ -1,11 +1,237 @@
+#include <algorithm>
+#include <cerrno>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "benchmark.h"
 
 std::size_t NUM = 10000000000;
 
-int main() {
-  for (unsigned long i = 0; i < NUM; ++i) {
-    printf("Hello World\n");
+namespace {
+
+const char RECORD[] = "Hello World\n";
+
+/* Writes one record over and over in large blocks. The block holds whole
+ * records and whole pages, is filled once and never changes, so every
+ * system call hands the same memory to the kernel, many times over with
+ * writev. A pipe gets it with vmsplice, which maps the pages into the
+ * pipe instead of copying them. The block is mapped, not allocated,
+ * so that its pages can't be reused while a pipe still refers to them.
+ */
+class BulkWriter {
+public:
+  static constexpr const std::size_t target_block_size = 1 << 20;
+  static constexpr const int max_iov = 16;
+
+  BulkWriter(const std::string& record) :
+    record_size_(record.size()), block_(nullptr), block_size_(0) {
+    std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t unit = page;
+    while (unit % record_size_ != 0) unit += page;
+    block_size_ = std::max<std::size_t>(1, target_block_size / unit) * unit;
+    void* block = mmap(nullptr, block_size_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED) {
+      throw benchmark::BenchmarkError("BulkWriter: Cannot map the block.");
+    }
+    block_ = static_cast<char*>(block);
+    for (std::size_t i = 0; i < block_size_; i += record_size_) {
+      std::memcpy(block_ + i, record.data(), record_size_);
+    }
+  }
+  ~BulkWriter() { munmap(block_, block_size_); }
+  BulkWriter(const BulkWriter&) = delete;
+  BulkWriter& operator=(const BulkWriter&) = delete;
+
+  /* Writes count records to fd, false with errno set on failure.
+   */
+  bool write(int fd, std::uint64_t count) const {
+    std::uint64_t total = count * record_size_, done = 0;
+    bool pipe = is_pipe(fd);
+#ifdef __linux__
+    if (pipe) fcntl(fd, F_SETPIPE_SZ, static_cast<int>(block_size_));
+#endif
+    while (done < total) {
+      iovec iov[max_iov];
+      int n = 0;
+      std::uint64_t offset = done % block_size_, left = total - done;
+      for (; n < max_iov && left > 0; ++n) {
+        std::size_t len = static_cast<std::size_t>(
+          std::min<std::uint64_t>(block_size_ - offset, left));
+        iov[n].iov_base = block_ + offset;
+        iov[n].iov_len = len;
+        left -= len;
+        offset = 0;
+      }
+      ssize_t written;
+#ifdef __linux__
+      if (pipe) {
+        written = vmsplice(fd, iov, n, 0);
+        if (written < 0 && (errno == EINVAL || errno == ENOSYS)) {
+          pipe = false;
+          continue;
+        }
+      } else
+#endif
+      written = writev(fd, iov, n);
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      done += written;
+    }
+    return true;
+  }
+
+private:
+  static bool is_pipe(int fd) {
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+  }
+
+  std::size_t record_size_;
+  char* block_;
+  std::size_t block_size_;
+};
+
+/* Output of a benchmark, /dev/null or a pipe that a thread drains into
+ * /dev/null, with splice where available.
+ */
+class Sink {
+public:
+  Sink(bool pipe) : fd_(-1), read_fd_(-1), drain_() {
+    if (!pipe) {
+      fd_ = open("/dev/null", O_WRONLY);
+      if (fd_ < 0) {
+        throw benchmark::BenchmarkError("Sink: Cannot open /dev/null.");
+      }
+      return;
+    }
+    int fds[2];
+    if (::pipe(fds) != 0) {
+      throw benchmark::BenchmarkError("Sink: Cannot create pipe.");
+    }
+    read_fd_ = fds[0];
+    fd_ = fds[1];
+    drain_ = std::thread([this] { drain(); });
+  }
+  ~Sink() {
+    close(fd_);
+    if (drain_.joinable()) drain_.join();
+    if (read_fd_ >= 0) close(read_fd_);
+  }
+  Sink(const Sink&) = delete;
+  Sink& operator=(const Sink&) = delete;
+
+  inline int fd() const { return fd_; }
+
+private:
+  void drain() {
+    int null = open("/dev/null", O_WRONLY);
+#ifdef __linux__
+    while (true) {
+      ssize_t n = splice(read_fd_, nullptr, null, nullptr,
+                         BulkWriter::target_block_size, SPLICE_F_MOVE);
+      if (n > 0 || (n < 0 && errno == EINTR)) continue;
+      if (n == 0) {
+        close(null);
+        return;
+      }
+      break;
+    }
+#endif
+    char buffer[1 << 16];
+    while (true) {
+      ssize_t n = read(read_fd_, buffer, sizeof(buffer));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) break;
+    }
+    close(null);
+  }
+
+  int fd_;
+  int read_fd_;
+  std::thread drain_;
+};
+
+/* The original loop, with stdout pointed at the sink.
+ */
+void BM_printf(benchmark::Timer& timer, std::size_t lines, bool pipe) {
+  Sink sink(pipe);
+  std::fflush(stdout);
+  int saved = dup(STDOUT_FILENO);
+  dup2(sink.fd(), STDOUT_FILENO);
+  while (timer.looping()) {
+    for (std::size_t i = 0; i < lines; ++i) {
+      printf("Hello World\n");
+    }
+    std::fflush(stdout);
+  }
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+  timer.set_bytes_processed(
+    static_cast<std::uint64_t>(lines) * (sizeof(RECORD) - 1) *
+    timer.iterations());
+}
+
+void BM_bulk(benchmark::Timer& timer, std::size_t lines, bool pipe) {
+  Sink sink(pipe);
+  BulkWriter writer(RECORD);
+  while (timer.looping()) {
+    if (!writer.write(sink.fd(), lines)) {
+      throw benchmark::BenchmarkError(std::string("BM_bulk: ") +
+                                      std::strerror(errno) + ".");
+    }
+  }
+  timer.set_bytes_processed(
+    static_cast<std::uint64_t>(lines) * (sizeof(RECORD) - 1) *
+    timer.iterations());
+}
+
+int run_benchmark(std::size_t lines) {
+  benchmark::FunctionBenchmark<std::size_t, bool> bm("helloworld");
+  bm.add("printf/null", "ms", 3, BM_printf, lines, false);
+  bm.add("bulk/null", "ms", 3, BM_bulk, lines, false);
+  bm.add("printf/pipe", "ms", 3, BM_printf, lines, true);
+  bm.add("bulk/pipe", "ms", 3, BM_bulk, lines, true);
+  bm.run();
+  for (const benchmark::Benchmark::Result& r : bm.result()) {
+    std::cout << r.label << ": " << r.bytes_per_second / 1e9 << " GB/s\n";
+  }
+  return 0;
+}
+
+}  // namespace
+
+/* helloworld               writes NUM lines to stdout
+ * helloworld --benchmark N compares printf and BulkWriter on N lines
+ */
+int main(int argc, char* argv[]) {
+  try {
+    if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+      return run_benchmark(argc > 2 ? std::strtoull(argv[2], nullptr, 10) :
+                                      10000000);
+    }
+    BulkWriter writer(RECORD);
+    if (!writer.write(STDOUT_FILENO, NUM)) {
+      std::perror("helloworld");
+      return 1;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
   }
   return 0;
 }
@@ -0,0 +1,177 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_HISTOGRAM_H_
+#define BENCHMARK_HISTOGRAM_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "error.h"
+
+namespace benchmark {
+
+/* Log-bucketed histogram of non-negative integer values in the style of
+ * HdrHistogram. Values below 2 * 2^precision_bits are counted exactly,
+ * larger ones fall into 2^precision_bits linear sub-buckets per power of
+ * two, so the relative error of a reported value is below 2^-precision_bits.
+ * The fixed-size bucket array is allocated on the first add().
+ */
+class Histogram {
+public:
+  Histogram(unsigned int precision_bits = 7) :
+    precision_bits_(precision_bits),
+    sub_buckets_(std::int64_t(1) << precision_bits),
+    counts_(),
+    total_(0) {
+    if (precision_bits_ == 0 || precision_bits_ > 16) {
+      throw BenchmarkError("Histogram::Histogram: Invalid precision.");
+    }
+  }
+
+  void add(std::int64_t value, std::uint64_t count = 1) {
+    if (value < 0) value = 0;
+    if (counts_.empty()) {
+      counts_.assign((64 - precision_bits_) * sub_buckets_, 0);
+    }
+    counts_[index_of(value)] += count;
+    total_ += count;
+  }
+  void merge(const Histogram& other) {
+    if (other.precision_bits_ != precision_bits_) {
+      throw BenchmarkError("Histogram::merge: Inconsistent precisions.");
+    }
+    if (other.total_ == 0) return;
+    if (counts_.empty()) counts_.assign(other.counts_.size(), 0);
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+  }
+  void clear() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_ = 0;
+  }
+
+  inline std::uint64_t count() const { return total_; }
+
+  /* Value at quantile q in [0, 1], the midpoint of the bucket holding the
+   * ceil(q * count())-th smallest value.
+   */
+  double quantile(double q) const {
+    if (total_ == 0) return 0;
+    if (q < 0) q = 0;
+    if (q > 1) q = 1;
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(q * total_));
+    if (rank == 0) rank = 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return (lower_bound_of(i) + upper_bound_of(i)) / 2.0;
+      }
+    }
+    return upper_bound_of(counts_.size() - 1);
+  }
+
+  /* Calls visit(lower, upper, count) for each non-empty bucket, where the
+   * bucket holds values in [lower, upper].
+   */
+  template <typename Visitor>
+  void for_each(Visitor visit) const {
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      if (counts_[i] != 0) {
+        visit(lower_bound_of(i), upper_bound_of(i), counts_[i]);
+      }
+    }
+  }
+
+private:
+  std::size_t index_of(std::int64_t value) const {
+    if (value < 2 * sub_buckets_) return static_cast<std::size_t>(value);
+    unsigned int msb = 63 - __builtin_clzll(static_cast<std::uint64_t>(value));
+    unsigned int shift = msb - precision_bits_;
+    return static_cast<std::size_t>(
+      (shift + 1) * sub_buckets_ + ((value >> shift) - sub_buckets_));
+  }
+  std::int64_t lower_bound_of(std::size_t index) const {
+    std::int64_t i = static_cast<std::int64_t>(index);
+    if (i < 2 * sub_buckets_) return i;
+    std::int64_t shift = i / sub_buckets_ - 1;
+    return (sub_buckets_ + i % sub_buckets_) << shift;
+  }
+  std::int64_t upper_bound_of(std::size_t index) const {
+    std::int64_t i = static_cast<std::int64_t>(index);
+    if (i < 2 * sub_buckets_) return i;
+    std::int64_t shift = i / sub_buckets_ - 1;
+    return lower_bound_of(index) + (std::int64_t(1) << shift) - 1;
+  }
+
+  unsigned int precision_bits_;
+  std::int64_t sub_buckets_;
+  std::vector<std::uint64_t> counts_;
+  std::uint64_t total_;
+};
+
+/* Constant-memory summary of a sample stream: Welford's online mean and
+ * variance, extremes and a Histogram for quantiles. Samples may carry
+ * fractions, only the histogram rounds them to integers.
+ */
+class StreamingStatistics {
+public:
+  StreamingStatistics() :
+    count_(0), mean_(0), m2_(0),
+    min_(std::numeric_limits<double>::max()), max_(0), histogram_() {}
+
+  void add(double value) {
+    ++count_;
+    double delta = value - mean_;
+    mean_ += delta / count_;
+    m2_ += delta * (value - mean_);
+    if (value < min_) min_ = value;
+    if (value > max_) max_ = value;
+    histogram_.add(std::llround(value));
+  }
+  void merge(const StreamingStatistics& other) {
+    if (other.count_ == 0) return;
+    std::uint64_t n = count_ + other.count_;
+    double delta = other.mean_ - mean_;
+    mean_ += delta * other.count_ / n;
+    m2_ += other.m2_ + delta * delta * count_ * other.count_ / n;
+    count_ = n;
+    if (other.min_ < min_) min_ = other.min_;
+    if (other.max_ > max_) max_ = other.max_;
+    histogram_.merge(other.histogram_);
+  }
+  void clear() { *this = StreamingStatistics(); }
+
+  inline std::uint64_t count() const { return count_; }
+  inline double mean() const { return mean_; }
+  /* Population variance, as reported by Benchmark::Result::variance.
+   */
+  inline double variance() const { return count_ == 0 ? 0 : m2_ / count_; }
+  inline double min() const { return count_ == 0 ? 0 : min_; }
+  inline double max() const { return max_; }
+  double quantile(double q) const {
+    if (count_ == 0) return 0;
+    double value = histogram_.quantile(q);
+    if (value < min_) return min_;
+    if (value > max_) return max_;
+    return value;
+  }
+  inline const Histogram& histogram() const { return histogram_; }
+
+private:
+  std::uint64_t count_;
+  double mean_;
+  double m2_;
+  double min_;
+  double max_;
+  Histogram histogram_;
+};
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_HISTOGRAM_H_
@@ -0,0 +1,275 @@
+/* 2026-10-18 */
+/*
+
+Characterization of the machine a report was measured on:
+
+const MachineContext& context = machine_context();
+context.cpu_model;    // "Intel(R) Xeon(R) ..."
+context.calibration;  // results of the kernels below
+
+Numbers from two machines, or from one machine in two states, are only
+comparable next to what that machine could do at the time. The context
+records the CPU, its frequency governor and core counts, and runs a few
+calibration kernels through FunctionBenchmark:
+
+stream/copy, stream/scale, stream/add, stream/triad
+    STREAM kernels over arrays of at least four times the last-level
+    cache, bytes_per_second is the sustained memory bandwidth.
+latency/<bytes>
+    Dependent loads through a random cycle of cache lines, ns_per_load
+    from L1 sized working sets up to DRAM.
+flops/scalar, flops/simd
+    Independent multiply-add chains, items_per_second is FLOP/s, once on
+    plain doubles and once on vectors of four.
+
+The context is gathered once per process, on first use, and takes a few
+seconds. JsonReporter stores it with every report.
+
+*/
+
+#ifndef BENCHMARK_MACHINE_H_
+#define BENCHMARK_MACHINE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "cache.h"
+#include "optimization.h"
+#include "timer.h"
+
+namespace benchmark {
+
+struct MachineContext {
+  std::string cpu_model;  // "unknown" where not found
+  std::string governor;   // frequency governor of CPU 0, "unknown" likewise
+  std::size_t logical_cpus;
+  std::size_t physical_cores;
+  std::size_t last_level_cache;  // bytes, 0 if unknown
+  std::vector<Benchmark::Result> calibration;
+};
+
+namespace internal {
+
+inline std::string trim(const std::string& s) {
+  std::size_t begin = s.find_first_not_of(" \t");
+  if (begin == std::string::npos) return "";
+  std::size_t end = s.find_last_not_of(" \t\r\n");
+  return s.substr(begin, end - begin + 1);
+}
+
+/* Fills the model and the core counts from /proc/cpuinfo. Physical cores
+ * are the distinct (physical id, core id) pairs, the logical CPUs if the
+ * file does not list them.
+ */
+inline void read_cpuinfo(MachineContext& context) {
+  std::ifstream file("/proc/cpuinfo");
+  std::string line, physical_id;
+  std::set<std::pair<std::string, std::string>> cores;
+  while (std::getline(file, line)) {
+    std::size_t colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    std::string key = trim(line.substr(0, colon));
+    std::string value = trim(line.substr(colon + 1));
+    if (context.cpu_model == "unknown" &&
+        (key == "model name" || key == "Processor" || key == "cpu model")) {
+      context.cpu_model = value;
+    } else if (key == "physical id") {
+      physical_id = value;
+    } else if (key == "core id") {
+      cores.insert(std::make_pair(physical_id, value));
+    }
+  }
+  if (!cores.empty()) context.physical_cores = cores.size();
+}
+
+inline void stream_copy(Timer& timer, std::size_t n) {
+  std::vector<double> a(n, 1.0), c(n, 0.0);
+  while (timer.looping()) {
+    for (std::size_t i = 0; i < n; ++i) c[i] = a[i];
+    clobber_memory();
+  }
+  timer.set_bytes_processed(2 * sizeof(double) * n * timer.iterations());
+}
+inline void stream_scale(Timer& timer, std::size_t n) {
+  std::vector<double> b(n, 0.0), c(n, 1.0);
+  const double scalar = 3.0;
+  while (timer.looping()) {
+    for (std::size_t i = 0; i < n; ++i) b[i] = scalar * c[i];
+    clobber_memory();
+  }
+  timer.set_bytes_processed(2 * sizeof(double) * n * timer.iterations());
+}
+inline void stream_add(Timer& timer, std::size_t n) {
+  std::vector<double> a(n, 1.0), b(n, 2.0), c(n, 0.0);
+  while (timer.looping()) {
+    for (std::size_t i = 0; i < n; ++i) c[i] = a[i] + b[i];
+    clobber_memory();
+  }
+  timer.set_bytes_processed(3 * sizeof(double) * n * timer.iterations());
+}
+inline void stream_triad(Timer& timer, std::size_t n) {
+  std::vector<double> a(n, 0.0), b(n, 2.0), c(n, 1.0);
+  const double scalar = 3.0;
+  while (timer.looping()) {
+    for (std::size_t i = 0; i < n; ++i) a[i] = b[i] + scalar * c[i];
+    clobber_memory();
+  }
+  timer.set_bytes_processed(3 * sizeof(double) * n * timer.iterations());
+}
+
+/* Follows a single random cycle through bytes of cache lines, so every
+ * load depends on the previous one and the prefetchers cannot guess it.
+ */
+inline void pointer_chase(Timer& timer, std::size_t bytes) {
+  struct Line {
+    Line* next;
+    char padding[CacheEvictor::line_size - sizeof(Line*)];
+  };
+  const std::size_t loads = 1 << 18;
+  std::size_t n = std::max<std::size_t>(bytes / sizeof(Line), 2);
+  std::vector<Line> lines(n);
+  std::vector<std::size_t> order(n);
+  for (std::size_t i = 0; i < n; ++i) order[i] = i;
+  std::mt19937_64 rng(5489u);
+  // Sattolo's algorithm, a permutation that is one cycle of length n.
+  for (std::size_t i = n - 1; i > 0; --i) {
+    std::swap(order[i], order[rng() % i]);
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    lines[order[i]].next = &lines[order[(i + 1) % n]];
+  }
+  Line* p = &lines[0];
+  while (timer.looping()) {
+    for (std::size_t i = 0; i < loads; ++i) p = p->next;
+    do_not_optimize(p);
+  }
+  double total = static_cast<double>(loads) * timer.iterations();
+  timer.set_items_processed(loads * timer.iterations());
+  timer.set_counter("ns_per_load", timer.duration().count() / total);
+}
+
+/* Eight independent chains of x = x * m + a, two FLOPs each. The chains
+ * hide the latency of the multiply-add, and m and a keep x finite and
+ * away from denormals.
+ */
+inline void flops_scalar(Timer& timer, std::size_t n) {
+  const double m = 0.999999, a = 1e-6;
+  double x0 = 1.0, x1 = 1.1, x2 = 1.2, x3 = 1.3;
+  double x4 = 1.4, x5 = 1.5, x6 = 1.6, x7 = 1.7;
+  while (timer.looping()) {
+    for (std::size_t i = 0; i < n; ++i) {
+      x0 = x0 * m + a; x1 = x1 * m + a; x2 = x2 * m + a; x3 = x3 * m + a;
+      x4 = x4 * m + a; x5 = x5 * m + a; x6 = x6 * m + a; x7 = x7 * m + a;
+    }
+    do_not_optimize(x0); do_not_optimize(x1);
+    do_not_optimize(x2); do_not_optimize(x3);
+    do_not_optimize(x4); do_not_optimize(x5);
+    do_not_optimize(x6); do_not_optimize(x7);
+  }
+  timer.set_items_processed(16 * n * timer.iterations());
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+typedef double Vector4 __attribute__((vector_size(4 * sizeof(double))));
+#else
+struct Vector4 {
+  double lane[4];
+  Vector4 operator*(double s) const {
+    Vector4 res = *this;
+    for (double& x : res.lane) x *= s;
+    return res;
+  }
+  Vector4 operator+(double s) const {
+    Vector4 res = *this;
+    for (double& x : res.lane) x += s;
+    return res;
+  }
+};
+#endif
+
+/* The chains of flops_scalar on vectors of four doubles, as wide as the
+ * instruction set the library was compiled for allows.
+ */
+inline void flops_simd(Timer& timer, std::size_t n) {
+  const double m = 0.999999, a = 1e-6;
+  Vector4 x0 = {1.0, 1.1, 1.2, 1.3}, x1 = {1.4, 1.5, 1.6, 1.7};
+  Vector4 x2 = {2.0, 2.1, 2.2, 2.3}, x3 = {2.4, 2.5, 2.6, 2.7};
+  Vector4 x4 = {3.0, 3.1, 3.2, 3.3}, x5 = {3.4, 3.5, 3.6, 3.7};
+  Vector4 x6 = {4.0, 4.1, 4.2, 4.3}, x7 = {4.4, 4.5, 4.6, 4.7};
+  while (timer.looping()) {
+    for (std::size_t i = 0; i < n; ++i) {
+      x0 = x0 * m + a; x1 = x1 * m + a; x2 = x2 * m + a; x3 = x3 * m + a;
+      x4 = x4 * m + a; x5 = x5 * m + a; x6 = x6 * m + a; x7 = x7 * m + a;
+    }
+    do_not_optimize(x0); do_not_optimize(x1);
+    do_not_optimize(x2); do_not_optimize(x3);
+    do_not_optimize(x4); do_not_optimize(x5);
+    do_not_optimize(x6); do_not_optimize(x7);
+  }
+  timer.set_items_processed(4 * 16 * n * timer.iterations());
+}
+
+}  // namespace internal
+
+/* Runs the calibration kernels once each. STREAM arrays are four times
+ * the last-level cache, but between 16 and 128 MiB each so that the run
+ * stays short on machines with very large or unknown caches.
+ */
+inline std::vector<Benchmark::Result> run_calibration() {
+  std::size_t array_bytes = 4 * last_level_cache_size();
+  array_bytes = std::min<std::size_t>(
+    std::max<std::size_t>(array_bytes, 16 << 20), 128 << 20);
+  std::size_t n = array_bytes / sizeof(double);
+  std::vector<std::size_t> working_sets;
+  for (std::size_t bytes = 16 << 10; bytes <= (256 << 20); bytes <<= 2) {
+    working_sets.push_back(bytes);
+  }
+
+  FunctionBenchmark<std::size_t> calibration("calibration");
+  calibration.add("stream/copy", "ms", 3, internal::stream_copy, n);
+  calibration.add("stream/scale", "ms", 3, internal::stream_scale, n);
+  calibration.add("stream/add", "ms", 3, internal::stream_add, n);
+  calibration.add("stream/triad", "ms", 3, internal::stream_triad, n);
+  calibration.add_range("latency", "ms", 3, internal::pointer_chase,
+                        working_sets);
+  calibration.add("flops/scalar", "ms", 5, internal::flops_scalar,
+                  std::size_t(1) << 22);
+  calibration.add("flops/simd", "ms", 5, internal::flops_simd,
+                  std::size_t(1) << 22);
+  calibration.set_warmup(1);
+  return calibration.run();
+}
+
+/* Context of this process, gathered on the first call.
+ */
+inline const MachineContext& machine_context() {
+  static const MachineContext context = [] {
+    MachineContext res;
+    res.cpu_model = "unknown";
+    res.governor = "unknown";
+    res.logical_cpus = std::thread::hardware_concurrency();
+    res.physical_cores = res.logical_cpus;
+    res.last_level_cache = last_level_cache_size();
+    internal::read_cpuinfo(res);
+    std::ifstream governor(
+      "/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    std::string value;
+    if (governor >> value) res.governor = value;
+    res.calibration = run_calibration();
+    return res;
+  }();
+  return context;
+}
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_MACHINE_H_
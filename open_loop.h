@@ -0,0 +1,173 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_OPEN_LOOP_H_
+#define BENCHMARK_OPEN_LOOP_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "clock.h"
+#include "error.h"
+#include "histogram.h"
+#include "time_unit.h"
+
+namespace benchmark {
+
+/* Timer for open-loop load: operations are issued on a fixed schedule
+ * whether or not earlier ones have finished, and latency is measured from
+ * the intended start, so a stall also counts against the operations that
+ * should have been issued during it.
+
+OpenLoopTimer timer("queue", 100000, 50000);  // 50000 operations/s
+while (timer.looping()) queue.push(item);
+
+looping() ends the previous operation, then waits for the next intended
+start and returns at once if it is already late. Latencies go into a
+histogram-backed StreamingStatistics, so memory does not grow with the
+number of operations.
+*/
+class OpenLoopTimer {
+public:
+  typedef DefaultClock clock_type;
+  typedef clock_type::time_point time_point;
+  typedef std::chrono::nanoseconds duration_type;
+  static constexpr const TimeUnit time_unit = TimeUnit::ns;
+
+  /* constant issues at exact 1 / rate intervals, poisson draws the gaps
+   * from an exponential distribution with the same mean.
+   */
+  enum Schedule { constant, poisson };
+
+  const std::string label;
+
+  OpenLoopTimer(const std::string& timer_label, std::size_t operations,
+                double rate, Schedule schedule = constant,
+                std::uint64_t seed = 5489u) :
+    label(timer_label),
+    operations_(operations == 0 ? 1 : operations),
+    rate_(rate),
+    schedule_(schedule),
+    seed_(seed),
+    rng_(seed),
+    num_issued_(0),
+    first_start_(),
+    intended_start_(),
+    last_completion_(),
+    late_(0),
+    statistics_() {
+    if (!(rate > 0)) {
+      throw BenchmarkError("OpenLoopTimer: Rate must be positive.");
+    }
+  }
+
+  bool looping() {
+    time_point now = clock_type::now_end();
+    if (num_issued_ != 0) {
+      statistics_.add(clock_type::nanoseconds(intended_start_, now).count());
+      last_completion_ = now;
+    }
+    if (num_issued_ >= operations_) return false;
+    if (num_issued_ == 0) {
+      first_start_ = intended_start_ = clock_type::now();
+    } else {
+      intended_start_ += next_gap();
+      wait_until(intended_start_);
+    }
+    ++num_issued_;
+    return true;
+  }
+
+  void reset(std::size_t operations) {
+    operations_ = operations == 0 ? 1 : operations;
+    rng_.seed(seed_);
+    num_issued_ = 0;
+    late_ = 0;
+    statistics_.clear();
+  }
+  void reset() { reset(operations_); }
+
+  inline std::size_t operations() const { return operations_; }
+  inline double offered_rate() const { return rate_; }
+  inline Schedule schedule() const { return schedule_; }
+  /* Operations issued after their intended start because an earlier one
+   * was still running.
+   */
+  inline std::size_t late_operations() const { return late_; }
+
+  /* Wall time from the first intended start to the last completion.
+   * Pre-condition: looping() returned false
+   */
+  duration_type duration() const {
+    check_finished("duration");
+    return clock_type::nanoseconds(first_start_, last_completion_);
+  }
+  /* Completed operations per second of duration().
+   * Pre-condition: looping() returned false
+   */
+  double achieved_rate() const {
+    double seconds = duration().count() * 1e-9;
+    return seconds > 0 ? operations_ / seconds : 0;
+  }
+  /* Latencies in nanoseconds.
+   * Pre-condition: looping() returned false
+   */
+  const StreamingStatistics& statistics() const {
+    check_finished("statistics");
+    return statistics_;
+  }
+
+private:
+  /* Waits yield the CPU until this close to the target and then spin.
+   * Sleeping instead overshoots by up to milliseconds on loaded machines,
+   * which would show up as latency.
+   */
+  static constexpr const std::int64_t spin_threshold = 50000;  // ns
+
+  duration_type next_gap() {
+    double mean = 1e9 / rate_;
+    double gap = mean;
+    if (schedule_ == poisson) {
+      gap = std::exponential_distribution<double>(1 / mean)(rng_);
+    }
+    return duration_type(static_cast<std::int64_t>(gap));
+  }
+
+  void wait_until(const time_point& target) {
+    std::int64_t remaining =
+      clock_type::nanoseconds(clock_type::now(), target).count();
+    if (remaining <= 0) {
+      ++late_;
+      return;
+    }
+    while (remaining > 0) {
+      if (remaining > spin_threshold) std::this_thread::yield();
+      remaining = clock_type::nanoseconds(clock_type::now(), target).count();
+    }
+  }
+
+  void check_finished(const std::string& name) const {
+    if (num_issued_ < operations_ || statistics_.count() < operations_) {
+      throw BenchmarkError("OpenLoopTimer::" + name +
+                           ": The run has not finished.");
+    }
+  }
+
+  std::size_t operations_;
+  double rate_;  // operations per second
+  Schedule schedule_;
+  std::uint64_t seed_;
+  std::mt19937_64 rng_;
+  std::size_t num_issued_;
+  time_point first_start_;
+  time_point intended_start_;  // of the operation in flight
+  time_point last_completion_;
+  std::size_t late_;
+  StreamingStatistics statistics_;
+};
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_OPEN_LOOP_H_
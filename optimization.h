@@ -0,0 +1,85 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_OPTIMIZATION_H_
+#define BENCHMARK_OPTIMIZATION_H_
+
+#include <atomic>
+#include <type_traits>
+
+namespace benchmark {
+
+#if defined(__GNUC__) || defined(__clang__)
+
+/* Forces value to be computed and treated as read by code the compiler
+ * cannot see, so a result that is otherwise unused is not optimized away.
+ * The non-const overload additionally lets the compiler assume value was
+ * modified, which keeps loop-invariant computations inside the loop.
+ */
+template <typename T>
+inline void do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+template <typename T>
+inline typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                               sizeof(T) <= sizeof(T*)>::type
+do_not_optimize(T& value) {
+#if defined(__clang__)
+  asm volatile("" : "+r,m"(value) : : "memory");
+#else
+  asm volatile("" : "+m,r"(value) : : "memory");
+#endif
+}
+template <typename T>
+inline typename std::enable_if<!std::is_trivially_copyable<T>::value ||
+                               (sizeof(T) > sizeof(T*))>::type
+do_not_optimize(T& value) {
+  asm volatile("" : "+m"(value) : : "memory");
+}
+
+/* Makes the compiler assume all memory may have been read and written, so
+ * pending stores are flushed and later loads are not reused from before.
+ */
+inline void clobber_memory() {
+  asm volatile("" : : : "memory");
+}
+
+#else
+
+namespace internal {
+inline const volatile void*& optimization_sink() {
+  static const volatile void* sink = nullptr;
+  return sink;
+}
+}  // namespace internal
+
+/* Fallback for compilers without GNU inline assembly: publishing the
+ * address through a volatile object forces the value into memory, and a
+ * signal fence is a compiler-only barrier.
+ */
+template <typename T>
+inline void do_not_optimize(const T& value) {
+  internal::optimization_sink() = &value;
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+template <typename T>
+inline void do_not_optimize(T& value) {
+  internal::optimization_sink() = &value;
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+inline void clobber_memory() {
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+#endif
+
+/* Spellings used by Google Benchmark, so existing bodies port unchanged.
+ */
+template <typename T>
+inline void DoNotOptimize(T&& value) {
+  do_not_optimize(value);
+}
+inline void ClobberMemory() { clobber_memory(); }
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_OPTIMIZATION_H_
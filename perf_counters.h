@@ -0,0 +1,187 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_PERF_COUNTERS_H_
+#define BENCHMARK_PERF_COUNTERS_H_
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+
+/* Hardware counter readings. Counters that could not be opened are left
+ * out of mask and read as 0.
+ */
+struct PerfCounterValues {
+  enum Event { cycles, instructions, cache_misses, branch_misses, num_events };
+
+  double values[num_events];
+  unsigned int mask;
+
+  PerfCounterValues() : values(), mask(0) {}
+
+  inline bool has(Event e) const { return (mask & (1u << e)) != 0; }
+  inline double operator[](Event e) const { return values[e]; }
+
+  /* Instructions per cycle, 0 if either counter is missing.
+   */
+  double ipc() const {
+    if (!has(cycles) || !has(instructions) || values[cycles] == 0) return 0;
+    return values[instructions] / values[cycles];
+  }
+
+  PerfCounterValues& operator+=(const PerfCounterValues& other) {
+    for (int e = 0; e < num_events; ++e) values[e] += other.values[e];
+    mask |= other.mask;
+    return *this;
+  }
+  PerfCounterValues operator*(double n) const {
+    PerfCounterValues res(*this);
+    for (int e = 0; e < num_events; ++e) res.values[e] *= n;
+    return res;
+  }
+  PerfCounterValues operator/(double n) const {
+    PerfCounterValues res(*this);
+    for (int e = 0; e < num_events; ++e) res.values[e] /= n;
+    return res;
+  }
+
+  static const char* name(Event e) {
+    switch (e) {
+      case cycles: return "cycles"; break;
+      case instructions: return "instructions"; break;
+      case cache_misses: return "cache_misses"; break;
+      case branch_misses: return "branch_misses"; break;
+      default: return "unknown";
+    }
+  }
+};
+
+/* Group of perf_event counters for the calling thread, counting user space
+ * only. Opening never throws: when perf is unavailable or restricted
+ * (perf_event_paranoid, seccomp in containers, non-Linux hosts) available()
+ * is false, error() says why, and every other member is a no-op.
+ */
+class PerfCounters {
+public:
+  PerfCounters() : leader_(-1), num_open_(0), error_() {
+    for (int e = 0; e < PerfCounterValues::num_events; ++e) {
+      fds_[e] = -1;
+      order_[e] = PerfCounterValues::num_events;
+    }
+    open();
+  }
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  ~PerfCounters() { close(); }
+
+  inline bool available() const { return leader_ >= 0; }
+  inline const std::string& error() const { return error_; }
+
+  void enable() {
+#ifdef __linux__
+    if (available()) {
+      ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+  void disable() {
+#ifdef __linux__
+    if (available()) {
+      ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+  void reset() {
+#ifdef __linux__
+    if (available()) {
+      ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+
+  /* Counts since the last reset(), scaled up if the kernel multiplexed the
+   * group.
+   */
+  PerfCounterValues read() const {
+    PerfCounterValues res;
+#ifdef __linux__
+    if (!available()) return res;
+    std::uint64_t buf[3 + PerfCounterValues::num_events];
+    ssize_t n = ::read(leader_, buf, sizeof(buf));
+    if (n < static_cast<ssize_t>(3 * sizeof(std::uint64_t))) return res;
+    double scale = 1;
+    if (buf[2] != 0 && buf[2] < buf[1]) {
+      scale = static_cast<double>(buf[1]) / buf[2];
+    }
+    for (std::uint64_t i = 0; i < buf[0] && i < num_open_; ++i) {
+      int e = order_[i];
+      res.values[e] = buf[3 + i] * scale;
+      res.mask |= 1u << e;
+    }
+#endif
+    return res;
+  }
+
+private:
+  void open() {
+#ifdef __linux__
+    static const std::uint64_t configs[PerfCounterValues::num_events] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for (int e = 0; e < PerfCounterValues::num_events; ++e) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[e];
+      attr.disabled = leader_ < 0 ? 1 : 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP |
+                         PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1,
+                                        leader_, PERF_FLAG_FD_CLOEXEC));
+      if (fd < 0) {
+        if (error_.empty()) {
+          error_ = std::string("perf_event_open: ") + std::strerror(errno);
+        }
+        continue;
+      }
+      if (leader_ < 0) leader_ = fd;
+      fds_[e] = fd;
+      order_[num_open_++] = e;
+    }
+    if (available()) error_.clear();
+#else
+    error_ = "perf_event_open: Not supported on this platform.";
+#endif
+  }
+  void close() {
+#ifdef __linux__
+    for (int e = 0; e < PerfCounterValues::num_events; ++e) {
+      if (fds_[e] >= 0) ::close(fds_[e]);
+    }
+#endif
+  }
+
+  int leader_;
+  int fds_[PerfCounterValues::num_events];
+  int order_[PerfCounterValues::num_events];  // event of each group member
+  std::size_t num_open_;
+  std::string error_;
+};
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_PERF_COUNTERS_H_
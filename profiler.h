@@ -0,0 +1,306 @@
+/* 2026-10-18 */
+/*
+
+In-process sampling profiler, active only while a profiled Timer runs:
+
+Profiler profiler;
+FunctionBenchmark<std::size_t> bm("sort");
+bm.set_profiler(&profiler);
+bm.add("sort/1024", "us", 1000, BM_sort, 1024);
+bm.run();
+bm.profile(0);  // "main;...;BM_sort;std::sort<...>" -> samples
+
+setitimer(ITIMER_PROF) delivers SIGPROF every 1/frequency seconds of CPU
+time of the process. The handler records the stack of the interrupted
+thread with backtrace() into a preallocated slot, but only if a profiled
+timer is running on that thread, so setup, pauses and the harness itself
+are never sampled. Stacks are symbolized once the run is over, with
+dladdr() and the C++ demangler. Functions of the executable only resolve
+to names when it is linked with -rdynamic, otherwise they are given as
+module+0xoffset for addr2line.
+
+JsonReporter writes the folded stacks of each item next to the report,
+ready for flamegraph.pl.
+
+The profiler owns SIGPROF while it runs, and system calls of the body
+that are not restarted after a signal may fail with EINTR.
+
+*/
+
+#ifndef BENCHMARK_PROFILER_H_
+#define BENCHMARK_PROFILER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && defined(__GLIBC__)
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sys/time.h>
+#define BENCHMARK_HAS_PROFILER 1
+#endif
+
+#include "error.h"
+
+namespace benchmark {
+
+/* Samples per stack, keyed by the frames from the outermost to the
+ * innermost joined with ';', the folded format of flame graphs.
+ */
+typedef std::map<std::string, std::size_t> FoldedStacks;
+
+namespace internal {
+
+/* Set while a profiled timer runs on the calling thread, read by the
+ * signal handler, see Timer::set_profiling.
+ */
+inline volatile std::sig_atomic_t& profiled_thread() {
+  static thread_local volatile std::sig_atomic_t active = 0;
+  return active;
+}
+
+inline void write_folded(std::ostream& os, const FoldedStacks& stacks) {
+  for (const auto& stack : stacks) {
+    os << stack.first << " " << stack.second << "\n";
+  }
+}
+
+}  // namespace internal
+
+/* Only one profiler can run at a time. Samples beyond capacity are
+ * dropped and counted.
+ */
+class Profiler {
+public:
+  static constexpr const std::size_t max_depth = 64;
+  static constexpr const int default_frequency = 997;  // Hz, off the tick
+
+  Profiler(int frequency = default_frequency, std::size_t capacity = 1 << 14) :
+    frequency_(frequency), samples_(capacity == 0 ? 1 : capacity), next_(0),
+    running_(false) {
+    if (frequency_ <= 0 || frequency_ > 1000000) {
+      throw BenchmarkError("Profiler::Profiler: Invalid frequency.");
+    }
+  }
+  ~Profiler() { stop(); }
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  /* Arms the interval timer. Without support for it on this platform the
+   * profiler runs but takes no samples.
+   */
+  void start() {
+    if (running_) return;
+#ifdef BENCHMARK_HAS_PROFILER
+    Profiler* expected = nullptr;
+    if (!active().compare_exchange_strong(expected, this)) {
+      throw BenchmarkError("Profiler::start: Another profiler is running.");
+    }
+    install_handler();
+    long period = 1000000 / frequency_;  // us
+    itimerval interval;
+    interval.it_interval.tv_sec = period / 1000000;
+    interval.it_interval.tv_usec = period % 1000000;
+    interval.it_value = interval.it_interval;
+    if (setitimer(ITIMER_PROF, &interval, nullptr) != 0) {
+      active().store(nullptr);
+      throw BenchmarkError("Profiler::start: Cannot set the interval timer.");
+    }
+#endif
+    running_ = true;
+  }
+  void stop() {
+    if (!running_) return;
+#ifdef BENCHMARK_HAS_PROFILER
+    itimerval off;
+    std::memset(&off, 0, sizeof(off));
+    setitimer(ITIMER_PROF, &off, nullptr);
+    active().store(nullptr);
+#endif
+    running_ = false;
+  }
+  /* Drops all samples.
+   * Pre-condition: running_ == false
+   */
+  void clear() {
+    if (!(!running_)) {
+      throw BenchmarkError("Profiler::clear: Invalid pre-condition.");
+    }
+    for (Sample& sample : samples_) sample.depth = 0;
+    next_.store(0);
+  }
+
+  inline bool running() const { return running_; }
+  inline int frequency() const { return frequency_; }
+  std::size_t samples() const {
+    return std::min<std::size_t>(next_.load(), samples_.size());
+  }
+  std::size_t dropped() const { return next_.load() - samples(); }
+
+  /* Pre-condition: running_ == false
+   */
+  FoldedStacks folded() const {
+    if (!(!running_)) {
+      throw BenchmarkError("Profiler::folded: Invalid pre-condition.");
+    }
+    FoldedStacks res;
+#ifdef BENCHMARK_HAS_PROFILER
+    std::map<void*, std::string> names;
+    for (std::size_t i = 0; i < samples(); ++i) {
+      const Sample& sample = samples_[i];
+      if (sample.depth <= skipped_frames) continue;
+      std::string stack;
+      for (int f = sample.depth - 1; f >= skipped_frames; --f) {
+        // Outer frames hold return addresses, which may already point
+        // past the end of the calling function.
+        void* address = f == skipped_frames ? sample.frames[f] :
+          static_cast<char*>(sample.frames[f]) - 1;
+        auto name = names.find(address);
+        if (name == names.end()) {
+          name = names.insert(
+            std::make_pair(address, symbolize(address))).first;
+        }
+        if (!stack.empty()) stack += ";";
+        stack += name->second;
+      }
+      ++res[stack];
+    }
+#endif
+    return res;
+  }
+
+private:
+  struct Sample {
+    int depth;
+    void* frames[max_depth];
+  };
+
+  /* The handler itself and the signal trampoline.
+   */
+  static constexpr const int skipped_frames = 2;
+
+  static std::atomic<Profiler*>& active() {
+    static std::atomic<Profiler*> profiler(nullptr);
+    return profiler;
+  }
+
+#ifdef BENCHMARK_HAS_PROFILER
+  /* Installed once and left in place, it ignores signals while no
+   * profiler runs, so a late SIGPROF cannot terminate the process.
+   */
+  static void install_handler() {
+    static const bool installed = [] {
+      // The first backtrace() loads the unwinder, which is not safe to do
+      // inside the handler.
+      void* frame;
+      backtrace(&frame, 1);
+      struct sigaction action;
+      std::memset(&action, 0, sizeof(action));
+      action.sa_handler = handle;
+      action.sa_flags = SA_RESTART;
+      sigemptyset(&action.sa_mask);
+      return sigaction(SIGPROF, &action, nullptr) == 0;
+    }();
+    if (!installed) {
+      active().store(nullptr);
+      throw BenchmarkError("Profiler::start: Cannot install the handler.");
+    }
+  }
+
+  static void handle(int) {
+    if (!internal::profiled_thread()) return;
+    Profiler* profiler = active().load(std::memory_order_acquire);
+    if (!profiler) return;
+    int saved_errno = errno;
+    std::size_t i = profiler->next_.fetch_add(1, std::memory_order_relaxed);
+    if (i < profiler->samples_.size()) {
+      Sample& sample = profiler->samples_[i];
+      sample.depth = backtrace(sample.frames, max_depth);
+    }
+    errno = saved_errno;
+  }
+
+  static std::string symbolize(void* address) {
+    std::ostringstream os;
+    Dl_info info;
+    if (dladdr(address, &info) == 0) {
+      os << address;
+      return os.str();
+    }
+    if (info.dli_sname) {
+      int status = 0;
+      char* demangled =
+        abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+      std::string res = status == 0 && demangled ? demangled : info.dli_sname;
+      std::free(demangled);
+      return res;
+    }
+    std::string module = info.dli_fname ? info.dli_fname : "?";
+    std::size_t slash = module.rfind('/');
+    if (slash != std::string::npos) module = module.substr(slash + 1);
+    os << module << "+0x" << std::hex
+       << (static_cast<char*>(address) - static_cast<char*>(info.dli_fbase));
+    return os.str();
+  }
+#endif
+
+  int frequency_;
+  std::vector<Sample> samples_;
+  std::atomic<std::size_t> next_;
+  bool running_;
+};
+
+namespace internal {
+
+/* Runs profiler, if any, for the lifetime of the session, so that it is
+ * stopped when the body throws. The calling thread is no longer marked as
+ * profiled once the session ends, even if its timer was left running.
+ */
+class ProfilerSession {
+public:
+  ProfilerSession(Profiler* profiler) : profiler_(profiler) {
+    if (!profiler_) return;
+    profiler_->stop();
+    profiler_->clear();
+    profiler_->start();
+  }
+  ~ProfilerSession() {
+    internal::profiled_thread() = 0;
+    if (profiler_) profiler_->stop();
+  }
+  ProfilerSession(const ProfilerSession&) = delete;
+  ProfilerSession& operator=(const ProfilerSession&) = delete;
+
+  /* Stops the profiler and moves its stacks to stacks, which stays empty
+   * without a profiler.
+   */
+  void finish(FoldedStacks& stacks) {
+    stacks.clear();
+    internal::profiled_thread() = 0;
+    if (!profiler_) return;
+    profiler_->stop();
+    stacks = profiler_->folded();
+    profiler_ = nullptr;
+  }
+
+private:
+  Profiler* profiler_;
+};
+
+}  // namespace internal
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_PROFILER_H_
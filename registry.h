@@ -0,0 +1,366 @@
+/* 2026-10-18 */
+/*
+
+Benchmarks registered at static initialization, each with its own
+signature:
+
+void BM_copy(Timer& timer, std::size_t n, const char* mode) { ... }
+BENCHMARK(BM_copy)->Args(1024, "fast")->Args(4096, "slow")->Unit("us");
+
+void BM_nop(Timer& timer) { while (timer.looping()) {} }
+BENCHMARK(BM_nop)->Iterations(AutoIterations(0.5))->Warmup(AutoWarmup());
+BENCHMARK(BM_lookup)->Args(1 << 20)->CacheModes();  // warm and cold items
+
+RegisteredBenchmark bm;  // one item per Args of every registration
+bm.run();
+
+Items are labelled name/arg0/arg1/..., or name without Args, and the
+items of one registration form a complexity group, one per cache mode
+with CacheModes. Each item calls its function through a pointer fixed at
+compile time, with the arguments unpacked from a tuple, so nothing
+type-erased sits between the run and the body and the call can be
+inlined. Only the dispatch to an item, once per run, is virtual.
+
+*/
+
+#ifndef BENCHMARK_REGISTRY_H_
+#define BENCHMARK_REGISTRY_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "cache.h"
+#include "error.h"
+#include "profiler.h"
+#include "timer.h"
+
+namespace benchmark {
+
+namespace internal {
+
+template <std::size_t... I>
+struct IndexSequence {};
+template <std::size_t N, std::size_t... I>
+struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...> {};
+template <std::size_t... I>
+struct MakeIndexSequence<0, I...> {
+  typedef IndexSequence<I...> type;
+};
+
+/* A registered function bound to the arguments of one item.
+ */
+class Invocation {
+public:
+  virtual ~Invocation() {}
+  virtual void invoke(Timer& timer) = 0;
+  virtual std::string label() const = 0;  // "/arg0/arg1/..."
+  virtual double complexity_n() const = 0;
+};
+
+template <typename Func, Func function, typename... Arguments>
+class BoundInvocation : public Invocation {
+public:
+  BoundInvocation(const std::tuple<Arguments...>& arguments) :
+    arguments_(arguments) {}
+
+  void invoke(Timer& timer) override {
+    call(timer, typename MakeIndexSequence<sizeof...(Arguments)>::type());
+  }
+  std::string label() const override {
+    std::ostringstream os;
+    LabelArguments<std::tuple<Arguments...>>::append(os, arguments_);
+    return os.str();
+  }
+  double complexity_n() const override {
+    return FirstArgument<std::tuple<Arguments...>>::value(arguments_);
+  }
+
+private:
+  template <std::size_t... I>
+  void call(Timer& timer, IndexSequence<I...>) {
+    function(timer, std::get<I>(arguments_)...);
+  }
+
+  std::tuple<Arguments...> arguments_;
+};
+
+/* The item of a registration without Args, only for functions that take
+ * nothing but the timer.
+ */
+template <typename Func, Func function, typename Signature = Func>
+struct DefaultInvocation {
+  static std::shared_ptr<Invocation> make() { return nullptr; }
+};
+template <typename Func, Func function, typename R>
+struct DefaultInvocation<Func, function, R (*)(Timer&)> {
+  static std::shared_ptr<Invocation> make() {
+    return std::make_shared<BoundInvocation<Func, function>>(std::tuple<>());
+  }
+};
+
+class Registration {
+public:
+  const std::string name;
+
+  Registration(const std::string& reg_name) :
+    name(reg_name), unit_symbol_("ns"), iterations_(1),
+    auto_iterations_(false, AutoIterations()), cache_modes_(false),
+    warmup_count_(0), auto_warmup_(false, AutoWarmup()), invocations_() {}
+  virtual ~Registration() {}
+
+  inline const std::string& unit_symbol() const { return unit_symbol_; }
+  inline std::size_t iterations() const { return iterations_; }
+  inline const std::pair<bool, AutoIterations>& auto_iterations() const {
+    return auto_iterations_;
+  }
+  inline bool cache_modes() const { return cache_modes_; }
+  void apply_warmup(Timer& timer) const {
+    if (auto_warmup_.first) timer.set_warmup(auto_warmup_.second);
+    else timer.set_warmup(warmup_count_);
+  }
+  /* Items of the registration, the default one if Args was never called.
+   */
+  std::vector<std::shared_ptr<Invocation>> invocations() const {
+    if (!invocations_.empty()) return invocations_;
+    std::shared_ptr<Invocation> item = default_invocation();
+    if (!item) {
+      throw BenchmarkError("BENCHMARK(" + name + "): "
+                           "Arguments are required.");
+    }
+    return std::vector<std::shared_ptr<Invocation>>(1, item);
+  }
+
+protected:
+  virtual std::shared_ptr<Invocation> default_invocation() const = 0;
+
+  std::string unit_symbol_;
+  std::size_t iterations_;
+  std::pair<bool, AutoIterations> auto_iterations_;
+  bool cache_modes_;
+  std::size_t warmup_count_;
+  std::pair<bool, AutoWarmup> auto_warmup_;
+  std::vector<std::shared_ptr<Invocation>> invocations_;
+};
+
+template <typename Func, Func function>
+class FunctionRegistration : public Registration {
+public:
+  FunctionRegistration(const std::string& reg_name) :
+    Registration(reg_name) {}
+
+  /* Adds an item calling function(timer, args...).
+   */
+  template <typename... Values>
+  FunctionRegistration* Args(Values&&... args) {
+    invocations_.push_back(std::make_shared<BoundInvocation<
+      Func, function, typename std::decay<Values>::type...>>(
+        std::make_tuple(std::forward<Values>(args)...)));
+    return this;
+  }
+  /* One of "ns", "us", "ms" and "s".
+   */
+  FunctionRegistration* Unit(const std::string& symbol) {
+    if (internal::to_time_unit(symbol) == TimeUnit::unknown) {
+      throw BenchmarkError("FunctionRegistration::Unit: Invalid argument.");
+    }
+    unit_symbol_ = symbol;
+    return this;
+  }
+  FunctionRegistration* Iterations(std::size_t n) {
+    iterations_ = n;
+    auto_iterations_.first = false;
+    return this;
+  }
+  FunctionRegistration* Iterations(const AutoIterations& policy) {
+    iterations_ = policy.initial_iterations;
+    auto_iterations_ = std::pair<bool, AutoIterations>(true, policy);
+    return this;
+  }
+  /* Runs every item both warm and cold, see
+   * FunctionBenchmark::add_cache_modes.
+   */
+  FunctionRegistration* CacheModes() {
+    cache_modes_ = true;
+    return this;
+  }
+  /* See Timer::set_warmup.
+   */
+  FunctionRegistration* Warmup(std::size_t n) {
+    warmup_count_ = n;
+    auto_warmup_.first = false;
+    return this;
+  }
+  FunctionRegistration* Warmup(const AutoWarmup& policy) {
+    auto_warmup_ = std::pair<bool, AutoWarmup>(true, policy);
+    return this;
+  }
+
+protected:
+  std::shared_ptr<Invocation> default_invocation() const override {
+    return DefaultInvocation<Func, function>::make();
+  }
+};
+
+inline std::vector<std::unique_ptr<Registration>>& registrations() {
+  static std::vector<std::unique_ptr<Registration>> res;
+  return res;
+}
+
+template <typename Func, Func function>
+FunctionRegistration<Func, function>* register_function(
+  const std::string& name) {
+  FunctionRegistration<Func, function>* res =
+    new FunctionRegistration<Func, function>(name);
+  registrations().push_back(std::unique_ptr<Registration>(res));
+  return res;
+}
+
+}  // namespace internal
+
+/* Runs the items of every registration, in the order they were registered.
+ */
+class RegisteredBenchmark : public Benchmark {
+public:
+  RegisteredBenchmark(const std::string& bm_label = "RegisteredBenchmark") :
+    Benchmark(bm_label), invocations_(), auto_iterations_(),
+    perf_counters_(false), listener_(nullptr), profiler_(nullptr) {
+    for (const auto& registration : internal::registrations()) {
+      add(*registration, nullptr);
+    }
+  }
+  /* Only the items whose label satisfies select.
+   */
+  RegisteredBenchmark(const std::string& bm_label,
+                      const std::function<bool(const std::string&)>& select) :
+    Benchmark(bm_label), invocations_(), auto_iterations_(),
+    perf_counters_(false), listener_(nullptr), profiler_(nullptr) {
+    for (const auto& registration : internal::registrations()) {
+      add(*registration, select);
+    }
+  }
+
+  /* See FunctionBenchmark::set_perf_counters.
+   */
+  void set_perf_counters(bool enable) { perf_counters_ = enable; }
+  /* See FunctionBenchmark::set_sample_listener.
+   */
+  void set_sample_listener(SampleListener* listener) { listener_ = listener; }
+  /* See FunctionBenchmark::set_profiler.
+   */
+  void set_profiler(Profiler* profiler) { profiler_ = profiler; }
+  /* Overrides the warmup of every item.
+   */
+  void set_warmup(std::size_t n) {
+    for (Timer& timer : timers_) {
+      timer.reset();
+      timer.set_warmup(n);
+    }
+  }
+  void set_warmup(const AutoWarmup& policy) {
+    for (Timer& timer : timers_) {
+      timer.reset();
+      timer.set_warmup(policy);
+    }
+  }
+  /* Overrides the iterations of every item.
+   */
+  void set_iterations(const AutoIterations& policy) {
+    for (auto& item : auto_iterations_) {
+      item = std::pair<bool, AutoIterations>(true, policy);
+    }
+  }
+
+  const Result& run(std::size_t index) override {
+    if (index >= results_.size()) {
+      throw BenchmarkError("RegisteredBenchmark::run: Index out of range.");
+    }
+    internal::Invocation& invocation = *invocations_[index];
+    timers_[index].reset();
+    if (perf_counters_) timers_[index].set_perf_counters(true);
+    timers_[index].set_sample_listener(listener_, listener_ ?
+      listener_->open_stream(label + "/" + results_[index].label) : 0);
+    auto body = [&invocation](Timer& timer) { invocation.invoke(timer); };
+    if (auto_iterations_[index].first) {
+      run_adaptive(timers_[index], auto_iterations_[index].second, body,
+                   profiler_, profiles_[index]);
+    } else {
+      run_profiled(timers_[index], profiler_, profiles_[index], body);
+    }
+    return Benchmark::run(index);
+  }
+  const std::vector<Result>& run() override {
+    for (std::size_t i = 0; i < results_.size(); ++i) {
+      run(i);
+    }
+    return results_;
+  }
+
+private:
+  void add(const internal::Registration& registration,
+           const std::function<bool(const std::string&)>& select) {
+    std::vector<CacheMode> modes(1, CacheMode::warm);
+    if (registration.cache_modes()) modes.push_back(CacheMode::cold);
+    std::vector<std::vector<std::size_t>> items(modes.size());
+    for (const auto& invocation : registration.invocations()) {
+      for (std::size_t m = 0; m < modes.size(); ++m) {
+        std::string item_label = registration.name + invocation->label();
+        if (registration.cache_modes()) {
+          item_label += "/cache:" + cache_mode_name(modes[m]);
+        }
+        if (select && !select(item_label)) continue;
+        Benchmark::add(item_label, registration.unit_symbol(),
+                       Timer(registration.iterations()));
+        timers_.back().set_cache_mode(modes[m]);
+        registration.apply_warmup(timers_.back());
+        results_.back().complexity_n = invocation->complexity_n();
+        invocations_.push_back(invocation);
+        auto_iterations_.push_back(registration.auto_iterations());
+        items[m].push_back(results_.size() - 1);
+      }
+    }
+    for (std::size_t m = 0; m < modes.size(); ++m) {
+      if (items[m].empty()) continue;
+      std::string group = registration.name;
+      if (registration.cache_modes()) {
+        group += "/cache:" + cache_mode_name(modes[m]);
+      }
+      complexity_groups_.push_back(std::make_pair(group, items[m]));
+    }
+  }
+
+  std::vector<std::shared_ptr<internal::Invocation>> invocations_;
+  std::vector<std::pair<bool, AutoIterations>> auto_iterations_;
+  bool perf_counters_;
+  SampleListener* listener_;
+  Profiler* profiler_;
+};
+
+}  // namespace benchmark
+
+#define BENCHMARK_CONCAT_(a, b) BENCHMARK_CONCAT_IMPL_(a, b)
+#define BENCHMARK_CONCAT_IMPL_(a, b) a##b
+
+#if defined(__GNUC__)
+#define BENCHMARK_UNUSED_ __attribute__((unused))
+#else
+#define BENCHMARK_UNUSED_
+#endif
+
+/* Registers fn(Timer&, ...) at static initialization and returns its
+ * registration for chaining Args, Unit and Iterations. fn must not be
+ * overloaded.
+ */
+#define BENCHMARK(fn)                                                      \
+  static ::benchmark::internal::Registration*                              \
+    BENCHMARK_CONCAT_(benchmark_registration_, __LINE__) BENCHMARK_UNUSED_ = \
+      ::benchmark::internal::register_function<decltype(&fn), &fn>(#fn)
+
+#endif  // BENCHMARK_REGISTRY_H_
@@ -1,28 +1,224 @@
 #ifndef BENCHMARK_REPORTER_H_
 #define BENCHMARK_REPORTER_H_
 
+#include <cmath>
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 #include "benchmark.h"
-// #include "experiment.h"
+#include "experiment.h"
 #include "error.h"
+#include "json.h"
+#include "machine.h"
 #include "timer.h"
 #include "time_unit.h"
 
 namespace benchmark {
 
+namespace internal {
+
+/* JSON has no literal for NaN or infinity, such values are written as
+ * null so that the report can always be parsed back.
+ */
+struct JsonNumberFormat {
+	double value;
+};
+inline std::ostream& operator<<(std::ostream& os, const JsonNumberFormat& n) {
+	if (std::isfinite(n.value)) {
+		os << n.value;
+	} else {
+		os << "null";
+	}
+	return os;
+}
+inline JsonNumberFormat json_number(double value) {
+	return JsonNumberFormat{value};
+}
+/* A string literal with quotes and backslashes escaped, so that any label
+ * reads back with json::parse.
+ */
+inline std::string json_string(const std::string& s) {
+	return json::Json(s).dump();
+}
+
+/* Fields of one result, one per line without a trailing newline. Shared
+ * with the converters of other report formats.
+ */
+inline void write_json_result(std::ostream& file,
+                               const Benchmark::Result& r,
+                               const std::string& indent) {
+	file << indent << "\"label\": " << internal::json_string(r.label) << ",\n"
+			 << indent << "\"time_unit\": \"" 
+			 << internal::time_unit_symbol(r.time_unit) << "\",\n"
+			 << indent << "\"iterations\": " << r.iterations << ",\n"
+			 << indent << "\"warmup_iterations\": " << r.warmup_iterations << ",\n"
+			 << indent << "\"threads\": " << r.threads << ",\n"
+			 << indent << "\"complexity_n\": " << internal::json_number(r.complexity_n) << ",\n"
+			 << indent << "\"duration\": " << internal::json_number(r.duration) << ",\n"
+			 << indent << "\"mean\": " << internal::json_number(r.mean) << ",\n"
+			 << indent << "\"variance\": " << internal::json_number(r.variance) << ",\n"
+			 << indent << "\"max\": " << internal::json_number(r.max) << ",\n"
+			 << indent << "\"min\": " << internal::json_number(r.min) << ",\n"
+			 << indent << "\"p50\": " << internal::json_number(r.p50) << ",\n"
+			 << indent << "\"p90\": " << internal::json_number(r.p90) << ",\n"
+			 << indent << "\"p99\": " << internal::json_number(r.p99) << ",\n"
+			 << indent << "\"p999\": " << internal::json_number(r.p999) << ",\n"
+			 << indent << "\"median\": " << internal::json_number(r.median) << ",\n"
+			 << indent << "\"mad\": " << internal::json_number(r.mad) << ",\n"
+			 << indent << "\"iqr\": " << internal::json_number(r.iqr) << ",\n"
+			 << indent << "\"mean_ci\": [" << internal::json_number(r.mean_ci.lower)
+			 << ", " << internal::json_number(r.mean_ci.upper) << "],\n"
+			 << indent << "\"median_ci\": [" << internal::json_number(r.median_ci.lower)
+			 << ", " << internal::json_number(r.median_ci.upper) << "],\n"
+			 << indent << "\"outliers\": {"
+			 << "\"low_severe\": " << r.outliers.low_severe << ", "
+			 << "\"low_mild\": " << r.outliers.low_mild << ", "
+			 << "\"high_mild\": " << r.outliers.high_mild << ", "
+			 << "\"high_severe\": " << r.outliers.high_severe << "},\n"
+			 << indent << "\"ops_per_second\": " << internal::json_number(r.ops_per_second) << ",\n"
+			 << indent << "\"bytes_per_second\": " << internal::json_number(r.bytes_per_second) << ",\n"
+			 << indent << "\"items_per_second\": " << internal::json_number(r.items_per_second) << ",\n"
+			 << indent << "\"allocations\": " << internal::json_number(r.allocations) << ",\n"
+			 << indent << "\"deallocations\": " << internal::json_number(r.deallocations) << ",\n"
+			 << indent << "\"allocated_bytes\": " << internal::json_number(r.allocated_bytes) << ",\n"
+			 << indent << "\"cycles\": " << r.cycles;
+	if (r.perf_counters.mask != 0) {
+		file << ",\n"
+				 << indent << "\"perf_counters\": {";
+		bool first = true;
+		for (int e = 0; e < PerfCounterValues::num_events; ++e) {
+			PerfCounterValues::Event event =
+				static_cast<PerfCounterValues::Event>(e);
+			if (!r.perf_counters.has(event)) continue;
+			file << (first ? "" : ", ") << "\""
+					 << PerfCounterValues::name(event) << "\": "
+					 << r.perf_counters[event];
+			first = false;
+		}
+		file << "},\n"
+				 << indent << "\"ipc\": " << internal::json_number(r.ipc);
+	}
+	if (!r.counters.empty()) {
+		file << ",\n"
+				 << indent << "\"counters\": {";
+		for (auto c = r.counters.cbegin(); c != r.counters.cend(); ++c) {
+			file << (c == r.counters.cbegin() ? "" : ", ")
+					 << internal::json_string(c->first) << ": " << internal::json_number(c->second);
+		}
+		file << "}";
+	}
+}
+
+/* The "context" member of a report, see machine_context(), followed by a
+ * comma and a newline. Calibration results keep only their rates.
+ */
+inline void write_json_context(std::ostream& file, const MachineContext& context) {
+	file << "  \"context\": {\n"
+			 << "    \"cpu_model\": " << json_string(context.cpu_model) << ",\n"
+			 << "    \"governor\": " << json_string(context.governor) << ",\n"
+			 << "    \"logical_cpus\": " << context.logical_cpus << ",\n"
+			 << "    \"physical_cores\": " << context.physical_cores << ",\n"
+			 << "    \"last_level_cache\": " << context.last_level_cache << ",\n"
+			 << "    \"calibration\": [";
+	for (std::size_t i = 0; i < context.calibration.size(); ++i) {
+		const Benchmark::Result& r = context.calibration[i];
+		file << (i == 0 ? "\n" : ",\n")
+				 << "      {"
+				 << "\"label\": " << json_string(r.label) << ", "
+				 << "\"median\": " << json_number(r.median) << ", "
+				 << "\"time_unit\": \"" << time_unit_symbol(r.time_unit) << "\", "
+				 << "\"bytes_per_second\": " << json_number(r.bytes_per_second) << ", "
+				 << "\"items_per_second\": " << json_number(r.items_per_second);
+		for (const auto& c : r.counters) {
+			file << ", " << json_string(c.first) << ": " << json_number(c.second);
+		}
+		file << "}";
+	}
+	file << "\n"
+			 << "    ]\n"
+			 << "  },\n";
+}
+
+}  // namespace internal
+
 class Reporter {
 public:
 	virtual ~Reporter() {}
   virtual void report(const Timer& timer) const = 0;
   virtual void report(const Benchmark& benchmark) const = 0;
-  // virtual void report(const Experiment& experiment) = 0;
+	/* Reports the benchmarks of the experiment one after another.
+	 */
+	virtual void report(const Experiment& experiment) const {
+		for (std::size_t i = 0; i < experiment.size(); ++i) {
+			report(experiment.benchmark(i));
+		}
+	}
 };
 
+/* Table for reading on a terminal, one line per item with the mean and
+ * median time per iteration, the half width of the median's confidence
+ * interval, the iteration count and the throughput.
+ */
 class ConsoleReporter : public Reporter {
+public:
+	ConsoleReporter(std::ostream& os = std::cout) : os_(os) {}
 
+	void report(const Timer& timer) const override {
+		double iterations = static_cast<double>(timer.iterations());
+		std::ostringstream line;
+		line << timer.label << ": " << timer.iterations() << " iterations, "
+				 << std::setprecision(4)
+				 << (iterations > 0 ? timer.duration().count() / iterations : 0)
+				 << " ns per iteration\n";
+		os_ << line.str();
+	}
+	void report(const Benchmark& benchmark) const override {
+		const std::vector<Benchmark::Result>& results = benchmark.result();
+		std::size_t width = 4;
+		for (const Benchmark::Result& r : results) {
+			width = std::max(width, r.label.size());
+		}
+		std::ostringstream table;
+		table << benchmark.label << "\n"
+					<< std::left << std::setw(width + 2) << "item" << std::right
+					<< std::setw(14) << "mean" << std::setw(14) << "median"
+					<< std::setw(14) << "+/-" << std::setw(14) << "iterations"
+					<< std::setw(14) << "ops/s" << "\n";
+		for (const Benchmark::Result& r : results) {
+			table << std::left << std::setw(width + 2) << r.label << std::right
+						<< std::setw(14) << time(r.mean, r.time_unit)
+						<< std::setw(14) << time(r.median, r.time_unit)
+						<< std::setw(14)
+						<< time((r.median_ci.upper - r.median_ci.lower) / 2, r.time_unit)
+						<< std::setw(14) << r.iterations
+						<< std::setw(14) << std::setprecision(4) << r.ops_per_second
+						<< "\n";
+		}
+		os_ << table.str();
+	}
+	void report(const Experiment& experiment) const override {
+		os_ << "Experiment: " << experiment.label << "\n";
+		for (std::size_t i = 0; i < experiment.size(); ++i) {
+			os_ << "\n";
+			report(experiment.benchmark(i));
+		}
+	}
+
+private:
+	static std::string time(TimeValue value, TimeUnit unit) {
+		std::ostringstream os;
+		os << std::setprecision(4) << value << " "
+			 << internal::time_unit_symbol(unit);
+		return os.str();
+	}
+
+	std::ostream& os_;
 };
 
 class FileReporter : public Reporter {
@@ -31,7 +227,7 @@ public:
 
 	virtual void report(const Timer& timer) const {}
 	virtual void report(const Benchmark& benchmark) const {}
-	// void report(const Experiment& experiment) {}
+	using Reporter::report;
 
 protected:
 	std::string filename_;
@@ -39,7 +235,11 @@ protected:
 
 class JsonReporter : public FileReporter {
 public:
-	JsonReporter(const std::string& filename) : FileReporter(filename) {}
+	/* With context, every report starts with the machine_context() of the
+	 * process, which runs the calibration kernels on the first report.
+	 */
+	JsonReporter(const std::string& filename, bool context = true) :
+		FileReporter(filename), context_(context) {}
 
 	void report(const Timer& timer) const override {
 		report_aux(timer);
@@ -47,24 +247,29 @@ public:
 	void report(const Benchmark& benchmark) const override {
 		report_aux(benchmark);
 	}
-	// void report(const Experiment& experiment) const override {
-	// 	std::ofstream file(filename_);
-	// 	std::ofstream file(filename_);
-	// 	if (!file.is_open()) {
-	// 		throw BenchmarkError("JsonReporter::report: Cannot open file.");
-	// 	}
-	// 	file << "{\n";
-	// 			 << "  Experiment: {\n"
-	// 			 << "    \"label\": \"" << experiment.label << "\"\n"
-	// 			 << "    \"benchmarks\": [\n";
-	// 	for (const Benchmark& bm : experiment.benchmarks_) {
-	// 		report_aux(bm, file, "  ");
-	// 	}
-	// 	file << "    ]\n"
-	// 	     << "  }\n"
-	// 	     << "}\n";
-	// 	file.close();
-	// }
+	void report(const Experiment& experiment) const override {
+		std::ofstream file(filename_);
+		if (!file.is_open()) {
+			throw BenchmarkError("JsonReporter::report: Cannot open file.");
+		}
+		file << "{\n";
+		if (context_) internal::write_json_context(file, machine_context());
+		file << "  \"Experiment\": {\n"
+				 << "    \"label\": " << internal::json_string(experiment.label) << ",\n"
+				 << "    \"benchmarks\": [";
+		for (std::size_t i = 0; i < experiment.size(); ++i) {
+			file << (i == 0 ? "\n" : ",\n")
+					 << "      {\n";
+			write_benchmark(experiment.benchmark(i), file, "    ");
+			file << "\n"
+					 << "      }";
+		}
+		file << "\n"
+				 << "    ]\n"
+				 << "  }\n"
+				 << "}\n";
+		file.close();
+	}
 
 private:
 	template <typename Tp>
@@ -74,6 +279,7 @@ private:
 			throw BenchmarkError("JsonReporter::report: Cannot open file.");
 		}
 		file << "{\n";
+		if (context_) internal::write_json_context(file, machine_context());
 		report_aux(x, file, "");
 		file << "}\n";
 		file.close();		
@@ -81,44 +287,137 @@ private:
 	void report_aux(const Timer& timer, std::ofstream& file, 
 									const std::string& indent) const {
 		file << indent << "  \"Timer\": {\n"
-				 << indent << "    \"label\": \"" << timer.label << "\",\n"
+				 << indent << "    \"label\": " << internal::json_string(timer.label) << ",\n"
 				 << indent << "    \"time_unit\": \"ns\",\n"
 				 << indent << "    \"duration\": " << timer.duration().count() << ",\n"
 				 << indent << "    \"iterations\": " << timer.iterations() << ",\n"
+				 << indent << "    \"cycles\": " << timer.cycles() << ",\n"
 				 << indent << "    \"loop_durations\": [";
 		auto durations = timer.durations();
-		for (std::size_t i = 0; i < durations.size() - 1; ++i) {
-			file << durations[i].count() << ", ";
+		for (std::size_t i = 0; i < durations.size(); ++i) {
+			if (i != 0) file << ", ";
+			file << durations[i].count();
+		}
+		file << "]";
+		if (timer.streaming()) {
+			const StreamingStatistics& stats = timer.statistics();
+			file << ",\n"
+					 << indent << "    \"statistics\": {\n"
+					 << indent << "      \"count\": " << stats.count() << ",\n"
+					 << indent << "      \"mean\": " << internal::json_number(stats.mean()) << ",\n"
+					 << indent << "      \"variance\": " << internal::json_number(stats.variance()) << ",\n"
+					 << indent << "      \"max\": " << internal::json_number(stats.max()) << ",\n"
+					 << indent << "      \"min\": " << internal::json_number(stats.min()) << ",\n"
+					 << indent << "      \"p50\": " << internal::json_number(stats.quantile(0.5)) << ",\n"
+					 << indent << "      \"p90\": " << internal::json_number(stats.quantile(0.9)) << ",\n"
+					 << indent << "      \"p99\": " << internal::json_number(stats.quantile(0.99)) << ",\n"
+					 << indent << "      \"p999\": " << internal::json_number(stats.quantile(0.999)) << "\n"
+					 << indent << "    }";
 		}
-		file << durations[durations.size() - 1].count() << "]\n"
+		file << "\n"
 		     << indent << "  }\n";
 	}
 	void report_aux(const Benchmark& benchmark, std::ofstream& file, 
 									const std::string& indent) const {
-		file << indent << "  \"Benchmark\": {\n"
-		     << indent << "    \"label\": \"" << benchmark.label << "\",\n"
+		file << indent << "  \"Benchmark\": {\n";
+		write_benchmark(benchmark, file, indent);
+		file << "\n"
+				 << indent << "  }\n";
+	}
+	/* Members of one benchmark object, indented by indent plus four spaces,
+	 * without the braces and a trailing newline.
+	 */
+	void write_benchmark(const Benchmark& benchmark, std::ofstream& file,
+											 const std::string& indent) const {
+		file << indent << "    \"label\": " << internal::json_string(benchmark.label) << ",\n"
 		     << indent << "    \"item\": [\n";
 		auto results = benchmark.result();
 		for (auto it = results.cbegin(); it != results.cend(); ++it) {
-			file << indent << "      {\n"
-					 << indent << "        \"label\": \"" << it->label << "\",\n"
-					 << indent << "        \"time_unit\": \"" 
-					 << indent << internal::time_unit_symbol(it->time_unit) << "\",\n"
-					 << indent << "        \"iterations\": " << it->iterations << ",\n"
-					 << indent << "        \"duration\": " << it->duration << ",\n"
-					 << indent << "        \"mean\": " << it->mean << ",\n"
-					 << indent << "        \"variance\": " << it->variance << ",\n"
-					 << indent << "        \"max\": " << it->max << ",\n"
-					 << indent << "        \"min\": " << it->min << "\n"
+			file << indent << "      {\n";
+			internal::write_json_result(file, *it, indent + "        ");
+			const auto& thread_results =
+				benchmark.thread_results(it - results.cbegin());
+			if (!thread_results.empty()) {
+				file << ",\n"
+						 << indent << "        \"thread_results\": [\n";
+				for (std::size_t t = 0; t < thread_results.size(); ++t) {
+					const Benchmark::Result& tr = thread_results[t];
+					file << indent << "          {"
+							 << "\"label\": " << internal::json_string(tr.label) << ", "
+							 << "\"iterations\": " << tr.iterations << ", "
+							 << "\"duration\": " << internal::json_number(tr.duration) << ", "
+							 << "\"mean\": " << internal::json_number(tr.mean) << ", "
+							 << "\"p50\": " << internal::json_number(tr.p50) << ", "
+							 << "\"p90\": " << internal::json_number(tr.p90) << ", "
+							 << "\"p99\": " << internal::json_number(tr.p99) << ", "
+							 << "\"max\": " << internal::json_number(tr.max) << ", "
+							 << "\"ops_per_second\": " << internal::json_number(tr.ops_per_second) << "}"
+							 << (t + 1 == thread_results.size() ? "\n" : ",\n");
+				}
+				file << indent << "        ]";
+			}
+			const FoldedStacks& stacks =
+				benchmark.profile(it - results.cbegin());
+			if (!stacks.empty()) {
+				std::string path = profile_filename(benchmark.label, it->label);
+				std::ofstream profile(path);
+				if (!profile.is_open()) {
+					throw BenchmarkError("JsonReporter::report: Cannot open file \"" +
+															 path + "\".");
+				}
+				internal::write_folded(profile, stacks);
+				file << ",\n"
+						 << indent << "        \"profile\": " << internal::json_string(path);
+			}
+			file << "\n"
 					 << indent << "      }";
 			if (it != results.cend() - 1) {
 				file << ",";
 			}
 			file << "\n";
 		}
-		file << indent << "    ]\n"
-				 << indent << "  }\n";;
+		file << indent << "    ]";
+		auto complexity = benchmark.complexity();
+		if (!complexity.empty()) {
+			file << ",\n"
+					 << indent << "    \"complexity\": [\n";
+			for (std::size_t i = 0; i < complexity.size(); ++i) {
+				file << indent << "      {"
+						 << "\"label\": " << internal::json_string(complexity[i].label) << ", "
+						 << "\"big_o\": \""
+						 << internal::big_o_symbol(complexity[i].fit.complexity) << "\", "
+						 << "\"coefficient\": " << internal::json_number(complexity[i].fit.coefficient) << ", "
+						 << "\"rms\": " << internal::json_number(complexity[i].fit.rms) << "}"
+						 << (i + 1 == complexity.size() ? "\n" : ",\n");
+			}
+			file << indent << "    ]";
+		}
 	}
+
+	/* The report's file name without its .json extension, followed by the
+	 * benchmark and item labels with anything but letters, digits, '-' and
+	 * '.' replaced by '_'.
+	 */
+	std::string profile_filename(const std::string& bm_label,
+															 const std::string& item_label) const {
+		std::string base = filename_;
+		const std::string extension = ".json";
+		if (base.size() > extension.size() &&
+				base.compare(base.size() - extension.size(), extension.size(),
+										 extension) == 0) {
+			base.resize(base.size() - extension.size());
+		}
+		std::string name = bm_label + "." + item_label;
+		for (char& c : name) {
+			if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' &&
+					c != '.') {
+				c = '_';
+			}
+		}
+		return base + "." + name + ".folded";
+	}
+
+	bool context_;
 };
 
 
@@ -0,0 +1,399 @@
+/* 2026-10-18 */
+/*
+
+Command line runner for registered benchmarks and experiments:
+
+BENCHMARK(BM_sort)->Args(1000)->Args(100000);
+BENCHMARK_MAIN();
+
+  bench [--filter=REGEX] [--repetitions=N] [--interleave[=SEED]]
+        [--min_time=SECONDS] [--warmup=N] [--warmup_iterations=N|auto]
+        [--format=console|json|binary] [--out=FILE] [--shard=I/N] [--list]
+  bench --merge=OUT shard0.json shard1.json ...
+
+Registered items are selected by their label, the benchmarks of added
+experiments as a whole by theirs, and everything selected runs as one
+Experiment with the runner's repetitions, warmup and order. --shard=I/N
+keeps every Nth selected unit starting at I, so N workers started with
+I = 0 .. N-1 split a suite between them without coordination; --merge
+joins their JSON reports into one.
+
+*/
+
+#ifndef BENCHMARK_RUNNER_H_
+#define BENCHMARK_RUNNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "binary_reporter.h"
+#include "compare.h"
+#include "error.h"
+#include "experiment.h"
+#include "json.h"
+#include "registry.h"
+#include "reporter.h"
+
+namespace benchmark {
+
+struct RunnerOptions {
+  std::string label;  // of the reported experiment
+  std::string filter;  // ECMAScript regex searched in labels, empty for all
+  std::size_t repetitions;
+  bool interleave;  // see Experiment::interleaved
+  std::uint64_t seed;
+  TimeValue min_time;  // seconds per registered item run, 0 for its own
+  std::size_t warmup;  // discarded runs before the first repetition
+  /* Warmup iterations inside every run of a registered item, a count or
+   * "auto" for AutoWarmup, empty keeps the item's own.
+   */
+  std::string warmup_iterations;
+  std::string format;  // console, json or binary
+  std::string output;  // report file of json and binary
+  std::size_t shard_index;
+  std::size_t shard_count;
+  bool list;  // print the selected labels instead of running
+  bool help;
+  std::string merge_output;
+  std::vector<std::string> merge_inputs;
+
+  RunnerOptions() :
+    label("benchmarks"), filter(), repetitions(1), interleave(false),
+    seed(5489u), min_time(0), warmup(0), warmup_iterations(),
+    format("console"), output(),
+    shard_index(0), shard_count(1), list(false), help(false),
+    merge_output(), merge_inputs() {}
+};
+
+namespace internal {
+
+inline std::uint64_t parse_count(const std::string& value,
+                                 const std::string& option) {
+  std::size_t end = 0;
+  unsigned long long res = 0;
+  try {
+    res = std::stoull(value, &end);
+  } catch (const std::exception&) {
+    end = 0;
+  }
+  if (value.empty() || end != value.size() || value[0] == '-') {
+    throw BenchmarkError("Runner: Invalid value \"" + value + "\" for --" +
+                         option + ".");
+  }
+  return res;
+}
+
+inline double parse_seconds(const std::string& value,
+                            const std::string& option) {
+  std::size_t end = 0;
+  double res = -1;
+  try {
+    res = std::stod(value, &end);
+  } catch (const std::exception&) {
+    end = 0;
+  }
+  if (value.empty() || end != value.size() || !(res >= 0)) {
+    throw BenchmarkError("Runner: Invalid value \"" + value + "\" for --" +
+                         option + ".");
+  }
+  return res;
+}
+
+inline const char* runner_usage() {
+  return "Usage: %s [--filter=REGEX] [--repetitions=N] "
+         "[--interleave[=SEED]]\n"
+         "          [--min_time=SECONDS] [--warmup=N] "
+         "[--warmup_iterations=N|auto]\n"
+         "          [--format=console|json|binary] [--out=FILE] "
+         "[--shard=I/N] [--list]\n"
+         "       %s --merge=OUT shard0.json shard1.json ...\n";
+}
+
+}  // namespace internal
+
+inline RunnerOptions parse_runner_options(int argc, char* argv[]) {
+  RunnerOptions res;
+  if (argc > 0) {
+    std::string program = argv[0];
+    std::size_t slash = program.find_last_of("/\\");
+    res.label = slash == std::string::npos ? program :
+                                             program.substr(slash + 1);
+  }
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 2, "--") != 0) {
+      positional.push_back(arg);
+      continue;
+    }
+    std::size_t eq = arg.find('=');
+    std::string name = arg.substr(2, eq == std::string::npos ?
+                                       std::string::npos : eq - 2);
+    std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    bool has_value = eq != std::string::npos;
+    if (name == "filter" && has_value) {
+      try {
+        std::regex check(value);
+      } catch (const std::regex_error&) {
+        throw BenchmarkError("Runner: Invalid value \"" + value +
+                             "\" for --filter.");
+      }
+      res.filter = value;
+    } else if (name == "repetitions" && has_value) {
+      res.repetitions = internal::parse_count(value, name);
+    } else if (name == "interleave") {
+      res.interleave = true;
+      if (has_value) res.seed = internal::parse_count(value, name);
+    } else if (name == "min_time" && has_value) {
+      res.min_time = internal::parse_seconds(value, name);
+    } else if (name == "warmup" && has_value) {
+      res.warmup = internal::parse_count(value, name);
+    } else if (name == "warmup_iterations" && has_value) {
+      if (value != "auto") internal::parse_count(value, name);
+      res.warmup_iterations = value;
+    } else if (name == "format" && has_value) {
+      if (value != "console" && value != "json" && value != "binary") {
+        throw BenchmarkError("Runner: Unknown format \"" + value + "\".");
+      }
+      res.format = value;
+    } else if (name == "out" && has_value) {
+      res.output = value;
+    } else if (name == "shard" && has_value) {
+      std::size_t slash = value.find('/');
+      if (slash == std::string::npos) {
+        throw BenchmarkError("Runner: --shard expects I/N.");
+      }
+      res.shard_index = internal::parse_count(value.substr(0, slash), name);
+      res.shard_count = internal::parse_count(value.substr(slash + 1), name);
+      if (res.shard_count == 0 || res.shard_index >= res.shard_count) {
+        throw BenchmarkError("Runner: --shard expects I < N.");
+      }
+    } else if (name == "list" && !has_value) {
+      res.list = true;
+    } else if (name == "help" && !has_value) {
+      res.help = true;
+    } else if (name == "merge" && has_value) {
+      res.merge_output = value;
+    } else {
+      throw BenchmarkError("Runner: Unknown option \"" + arg + "\".");
+    }
+  }
+  if (res.merge_output.empty() && !positional.empty()) {
+    throw BenchmarkError("Runner: Unexpected argument \"" +
+                         positional.front() + "\".");
+  }
+  if (!res.merge_output.empty() && positional.empty()) {
+    throw BenchmarkError("Runner: --merge needs shard reports.");
+  }
+  res.merge_inputs = positional;
+  if (res.format != "console" && res.output.empty() && !res.list) {
+    throw BenchmarkError("Runner: --format=" + res.format +
+                         " needs --out.");
+  }
+  return res;
+}
+
+/* Joins the JSON reports of the shards of one suite, given in shard order.
+ * Benchmarks are matched by label and their items dealt back round-robin,
+ * which restores the order of items the shards split between them.
+ * The machine context of the first shard is kept, complexity fits are
+ * not carried over.
+ */
+inline void merge_reports(const std::vector<std::string>& inputs,
+                          const std::string& output) {
+  std::string label;
+  json::Json context(nullptr);
+  std::vector<std::string> labels;
+  std::map<std::string, std::vector<std::vector<json::Json>>> items;
+  for (std::size_t s = 0; s < inputs.size(); ++s) {
+    json::Json report = read_report(inputs[s]);
+    if (!report.is_object() || !report.has("Experiment") ||
+        !report["Experiment"].has("benchmarks")) {
+      throw BenchmarkError("merge_reports: \"" + inputs[s] +
+                           "\" is not an experiment report.");
+    }
+    if (report.has("context") && context.is_null()) {
+      context = report["context"];
+    }
+    const json::Json& ex = report["Experiment"];
+    if (ex.has("label")) label = ex["label"].string();
+    const json::Json& benchmarks = ex["benchmarks"];
+    for (std::size_t b = 0; b < benchmarks.size(); ++b) {
+      const json::Json& bm = benchmarks[b];
+      std::string bm_label = bm["label"].string();
+      if (items.find(bm_label) == items.end()) {
+        labels.push_back(bm_label);
+        items[bm_label].resize(inputs.size());
+      }
+      const json::Json& bm_items = bm["item"];
+      for (std::size_t i = 0; i < bm_items.size(); ++i) {
+        items[bm_label][s].push_back(bm_items[i]);
+      }
+    }
+  }
+  std::vector<json::Json> benchmarks;
+  for (const std::string& bm_label : labels) {
+    const std::vector<std::vector<json::Json>>& shards = items[bm_label];
+    std::size_t total = 0;
+    for (const auto& shard : shards) total += shard.size();
+    std::vector<json::Json> merged;
+    for (std::size_t k = 0; merged.size() < total; ++k) {
+      for (const auto& shard : shards) {
+        if (k < shard.size()) merged.push_back(shard[k]);
+      }
+    }
+    std::map<std::string, json::Json> bm;
+    bm["label"] = json::Json(bm_label);
+    bm["item"] = json::Json(merged);
+    benchmarks.push_back(json::Json(bm));
+  }
+  std::map<std::string, json::Json> ex;
+  ex["label"] = json::Json(label);
+  ex["benchmarks"] = json::Json(benchmarks);
+  std::map<std::string, json::Json> report;
+  if (!context.is_null()) report["context"] = context;
+  report["Experiment"] = json::Json(ex);
+  std::ofstream file(output);
+  if (!file.is_open()) {
+    throw BenchmarkError("merge_reports: Cannot open file \"" + output +
+                         "\".");
+  }
+  file << json::Json(report).dump() << "\n";
+}
+
+class Runner {
+public:
+  Runner(const RunnerOptions& options) : options_(options), experiments_() {}
+
+  /* The benchmarks of experiment are selected and sharded as a whole and
+   * run with the runner's settings instead of the experiment's.
+   */
+  void add(Experiment& experiment) {
+    experiments_.push_back(&experiment);
+  }
+
+  /* Runs this shard's share of the selected units and reports it as one
+   * experiment, the console report goes to os.
+   */
+  void run(std::ostream& os = std::cout) {
+    std::regex filter(options_.filter.empty() ? "" : options_.filter);
+    RegisteredBenchmark all(options_.label);
+    std::vector<std::string> labels;
+    std::vector<Benchmark*> units;  // null for registered items
+    for (const Benchmark::Result& r : all.result()) {
+      labels.push_back(r.label);
+      units.push_back(nullptr);
+    }
+    for (Experiment* ex : experiments_) {
+      for (std::size_t i = 0; i < ex->size(); ++i) {
+        labels.push_back(ex->benchmark(i).label);
+        units.push_back(&ex->benchmark(i));
+      }
+    }
+    std::set<std::string> items;
+    std::vector<Benchmark*> benchmarks;
+    std::size_t position = 0;
+    for (std::size_t u = 0; u < units.size(); ++u) {
+      if (!std::regex_search(labels[u], filter)) continue;
+      if (position++ % options_.shard_count != options_.shard_index) continue;
+      if (options_.list) os << labels[u] << "\n";
+      if (units[u]) benchmarks.push_back(units[u]);
+      else items.insert(labels[u]);
+    }
+    if (options_.list) return;
+
+    RegisteredBenchmark registered(options_.label,
+      [&items](const std::string& l) { return items.count(l) != 0; });
+    if (options_.min_time > 0) {
+      registered.set_iterations(AutoIterations(options_.min_time));
+    }
+    if (options_.warmup_iterations == "auto") {
+      registered.set_warmup(AutoWarmup());
+    } else if (!options_.warmup_iterations.empty()) {
+      registered.set_warmup(static_cast<std::size_t>(internal::parse_count(
+        options_.warmup_iterations, "warmup_iterations")));
+    }
+    Experiment ex(options_.label);
+    if (!registered.result().empty()) ex.add(registered);
+    for (Benchmark* bm : benchmarks) ex.add(*bm);
+    ex.set_repetitions(options_.repetitions);
+    ex.set_warmup(options_.warmup);
+    ex.set_order(options_.interleave ? Experiment::interleaved :
+                                       Experiment::sequential,
+                 options_.seed);
+    if (options_.format == "binary") {
+      BinaryReporter reporter(options_.output);
+      registered.set_sample_listener(&reporter);
+      ex.run();
+      reporter.report(ex);
+      reporter.close();
+    } else if (options_.format == "json") {
+      ex.run();
+      JsonReporter(options_.output).report(ex);
+    } else {
+      ex.run();
+      ConsoleReporter(os).report(ex);
+    }
+  }
+
+private:
+  RunnerOptions options_;
+  std::vector<Experiment*> experiments_;
+};
+
+/* Parses the command line, runs or merges accordingly and returns the exit
+ * status: 0 on success, 1 on a failed run and 2 on a usage error.
+ */
+inline int runner_main(int argc, char* argv[],
+                       const std::vector<Experiment*>& experiments =
+                         std::vector<Experiment*>()) {
+  const char* program = argc > 0 ? argv[0] : "bench";
+  RunnerOptions options;
+  try {
+    options = parse_runner_options(argc, argv);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    std::fprintf(stderr, internal::runner_usage(), program, program);
+    return 2;
+  }
+  if (options.help) {
+    std::printf(internal::runner_usage(), program, program);
+    return 0;
+  }
+  try {
+    if (!options.merge_output.empty()) {
+      merge_reports(options.merge_inputs, options.merge_output);
+      return 0;
+    }
+    Runner runner(options);
+    for (Experiment* ex : experiments) runner.add(*ex);
+    runner.run();
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace benchmark
+
+/* Defines main() running the registered benchmarks.
+ */
+#define BENCHMARK_MAIN()                          \
+  int main(int argc, char* argv[]) {              \
+    return ::benchmark::runner_main(argc, argv);  \
+  }                                               \
+  int main(int, char*[])
+
+#endif  // BENCHMARK_RUNNER_H_
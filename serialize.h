@@ -0,0 +1,145 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_SERIALIZE_H_
+#define BENCHMARK_SERIALIZE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <type_traits>
+
+#include "benchmark.h"
+#include "error.h"
+
+namespace benchmark {
+namespace internal {
+
+/* Native-endian binary encoding of Benchmark::Result, meant for processes
+ * of the same build exchanging results, not for storage across builds.
+ */
+template <typename T>
+void put(std::string& out, const T& value) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "put: Type must be trivially copyable.");
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+inline void put(std::string& out, const std::string& s) {
+  put(out, static_cast<std::uint64_t>(s.size()));
+  out.append(s);
+}
+
+template <typename T>
+void get(const char*& p, const char* end, T& value) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "get: Type must be trivially copyable.");
+  if (end - p < static_cast<std::ptrdiff_t>(sizeof(T))) {
+    throw BenchmarkError("get: Truncated data.");
+  }
+  std::memcpy(&value, p, sizeof(T));
+  p += sizeof(T);
+}
+inline void get(const char*& p, const char* end, std::string& s) {
+  std::uint64_t size;
+  get(p, end, size);
+  if (static_cast<std::uint64_t>(end - p) < size) {
+    throw BenchmarkError("get: Truncated data.");
+  }
+  s.assign(p, size);
+  p += size;
+}
+
+inline void put(std::string& out, const std::map<std::string, double>& m) {
+  put(out, static_cast<std::uint64_t>(m.size()));
+  for (const auto& kv : m) {
+    put(out, kv.first);
+    put(out, kv.second);
+  }
+}
+inline void get(const char*& p, const char* end,
+                std::map<std::string, double>& m) {
+  std::uint64_t size;
+  get(p, end, size);
+  m.clear();
+  for (std::uint64_t i = 0; i < size; ++i) {
+    std::string key;
+    get(p, end, key);
+    get(p, end, m[key]);
+  }
+}
+
+inline void put(std::string& out, const Benchmark::Result& r) {
+  put(out, r.label);
+  put(out, r.time_unit);
+  put(out, static_cast<std::uint64_t>(r.iterations));
+  put(out, static_cast<std::uint64_t>(r.warmup_iterations));
+  put(out, r.duration);
+  put(out, r.mean);
+  put(out, r.variance);
+  put(out, r.max);
+  put(out, r.min);
+  put(out, r.p50);
+  put(out, r.p90);
+  put(out, r.p99);
+  put(out, r.p999);
+  put(out, r.median);
+  put(out, r.mad);
+  put(out, r.iqr);
+  put(out, r.mean_ci);
+  put(out, r.median_ci);
+  put(out, r.outliers);
+  put(out, r.cycles);
+  put(out, r.perf_counters);
+  put(out, r.ipc);
+  put(out, static_cast<std::uint64_t>(r.threads));
+  put(out, r.ops_per_second);
+  put(out, r.complexity_n);
+  put(out, r.bytes_per_second);
+  put(out, r.items_per_second);
+  put(out, r.counters);
+  put(out, r.allocations);
+  put(out, r.deallocations);
+  put(out, r.allocated_bytes);
+}
+inline void get(const char*& p, const char* end, Benchmark::Result& r) {
+  std::uint64_t n;
+  get(p, end, r.label);
+  get(p, end, r.time_unit);
+  get(p, end, n);
+  r.iterations = n;
+  get(p, end, n);
+  r.warmup_iterations = n;
+  get(p, end, r.duration);
+  get(p, end, r.mean);
+  get(p, end, r.variance);
+  get(p, end, r.max);
+  get(p, end, r.min);
+  get(p, end, r.p50);
+  get(p, end, r.p90);
+  get(p, end, r.p99);
+  get(p, end, r.p999);
+  get(p, end, r.median);
+  get(p, end, r.mad);
+  get(p, end, r.iqr);
+  get(p, end, r.mean_ci);
+  get(p, end, r.median_ci);
+  get(p, end, r.outliers);
+  get(p, end, r.cycles);
+  get(p, end, r.perf_counters);
+  get(p, end, r.ipc);
+  get(p, end, n);
+  r.threads = n;
+  get(p, end, r.ops_per_second);
+  get(p, end, r.complexity_n);
+  get(p, end, r.bytes_per_second);
+  get(p, end, r.items_per_second);
+  get(p, end, r.counters);
+  get(p, end, r.allocations);
+  get(p, end, r.deallocations);
+  get(p, end, r.allocated_bytes);
+}
+
+}  // namespace internal
+}  // namespace benchmark
+
+#endif  // BENCHMARK_SERIALIZE_H_
@@ -0,0 +1,415 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_STATISTICS_H_
+#define BENCHMARK_STATISTICS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "error.h"
+#include "histogram.h"
+
+namespace benchmark {
+
+struct Interval {
+  double lower;
+  double upper;
+};
+
+/* Tukey fences: mild outliers lie beyond 1.5 IQR from the quartiles,
+ * severe ones beyond 3 IQR.
+ */
+struct Outliers {
+  std::size_t low_severe;
+  std::size_t low_mild;
+  std::size_t high_mild;
+  std::size_t high_severe;
+
+  inline std::size_t total() const {
+    return low_severe + low_mild + high_mild + high_severe;
+  }
+};
+
+struct Summary {
+  std::size_t count;
+  double sum;
+  double mean;
+  double variance;  // population variance
+  double min;
+  double max;
+  double median;
+  double mad;  // median absolute deviation, unscaled
+  double q1;
+  double q3;
+  double p90;
+  double p99;
+  double p999;
+  Outliers outliers;
+  Interval mean_ci;
+  Interval median_ci;
+};
+
+struct SummaryOptions {
+  double confidence;
+  std::size_t resamples;
+  std::uint64_t seed;
+  /* Upper bound of resamples * count. When it allows fewer than
+   * min_resamples the large-sample intervals are used instead.
+   */
+  double max_bootstrap_work;
+
+  SummaryOptions(double conf = 0.95, std::size_t num_resamples = 1000,
+                 std::uint64_t rng_seed = 5489u,
+                 double max_work = 2e7) :
+    confidence(conf),
+    resamples(num_resamples),
+    seed(rng_seed),
+    max_bootstrap_work(max_work) {}
+
+  static constexpr const std::size_t min_resamples = 100;
+};
+
+namespace internal {
+
+/* Linearly interpolated quantile of sorted samples (Hyndman & Fan type 7).
+ */
+inline double sorted_quantile(const std::vector<double>& sorted, double q) {
+  if (sorted.empty()) return 0;
+  if (q <= 0) return sorted.front();
+  if (q >= 1) return sorted.back();
+  double h = (sorted.size() - 1) * q;
+  std::size_t lo = static_cast<std::size_t>(std::floor(h));
+  std::size_t hi = std::min(lo + 1, sorted.size() - 1);
+  return sorted[lo] + (h - lo) * (sorted[hi] - sorted[lo]);
+}
+
+/* Median of v, reordering v.
+ */
+inline double select_median(std::vector<double>& v) {
+  std::size_t mid = v.size() / 2;
+  std::nth_element(v.begin(), v.begin() + mid, v.end());
+  double upper = v[mid];
+  if (v.size() % 2 == 1) return upper;
+  double lower = *std::max_element(v.begin(), v.begin() + mid);
+  return (lower + upper) / 2;
+}
+
+/* Two-sided standard normal quantile for the given confidence, by
+ * bisection on erfc.
+ */
+inline double normal_critical_value(double confidence) {
+  double alpha = 1 - confidence;
+  double lo = 0, hi = 10;
+  for (int i = 0; i < 100; ++i) {
+    double mid = (lo + hi) / 2;
+    if (std::erfc(mid / std::sqrt(2.0)) > alpha) lo = mid;
+    else hi = mid;
+  }
+  return (lo + hi) / 2;
+}
+
+/* Normal approximation for the mean and binomial order-statistic bounds
+ * for the median, valid for large samples.
+ */
+template <typename Quantile>
+void asymptotic_intervals(Summary& res, double confidence,
+                          Quantile quantile) {
+  double z = normal_critical_value(confidence);
+  double n = static_cast<double>(res.count);
+  double half_width = z * std::sqrt(res.variance / n);
+  res.mean_ci = Interval{res.mean - half_width, res.mean + half_width};
+  double spread = z / (2 * std::sqrt(n));
+  res.median_ci = Interval{quantile(std::max(0.0, 0.5 - spread)),
+                           quantile(std::min(1.0, 0.5 + spread))};
+}
+
+}  // namespace internal
+
+/* Summary of stored samples. Moments, extremes and outliers are gathered in
+ * one pass over the sorted samples; confidence intervals for the mean and
+ * the median come from a percentile bootstrap with a fixed seed, or from
+ * the large-sample approximations once the bootstrap gets too expensive.
+ */
+inline Summary summarize(std::vector<double> samples,
+                         const SummaryOptions& options = SummaryOptions()) {
+  if (samples.empty()) {
+    throw BenchmarkError("summarize: No samples.");
+  }
+  std::sort(samples.begin(), samples.end());
+  Summary res;
+  res.count = samples.size();
+  res.min = samples.front();
+  res.max = samples.back();
+  res.q1 = internal::sorted_quantile(samples, 0.25);
+  res.median = internal::sorted_quantile(samples, 0.5);
+  res.q3 = internal::sorted_quantile(samples, 0.75);
+  res.p90 = internal::sorted_quantile(samples, 0.9);
+  res.p99 = internal::sorted_quantile(samples, 0.99);
+  res.p999 = internal::sorted_quantile(samples, 0.999);
+
+  double mean = 0, m2 = 0, sum = 0;
+  std::vector<double> deviations(samples.size());
+  Outliers outliers = {0, 0, 0, 0};
+  double iqr = res.q3 - res.q1;
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    double x = samples[i];
+    sum += x;
+    double delta = x - mean;
+    mean += delta / (i + 1);
+    m2 += delta * (x - mean);
+    deviations[i] = std::fabs(x - res.median);
+    if (x < res.q1 - 3 * iqr) ++outliers.low_severe;
+    else if (x < res.q1 - 1.5 * iqr) ++outliers.low_mild;
+    else if (x > res.q3 + 3 * iqr) ++outliers.high_severe;
+    else if (x > res.q3 + 1.5 * iqr) ++outliers.high_mild;
+  }
+  res.sum = sum;
+  res.mean = mean;
+  res.variance = m2 / samples.size();
+  res.mad = internal::select_median(deviations);
+  res.outliers = outliers;
+
+  if (samples.size() < 2) {
+    res.mean_ci = Interval{res.mean, res.mean};
+    res.median_ci = Interval{res.median, res.median};
+    return res;
+  }
+  std::size_t resamples = options.resamples;
+  if (resamples * static_cast<double>(samples.size()) >
+      options.max_bootstrap_work) {
+    resamples = static_cast<std::size_t>(
+      options.max_bootstrap_work / samples.size());
+  }
+  if (resamples < SummaryOptions::min_resamples) {
+    internal::asymptotic_intervals(res, options.confidence, [&](double q) {
+      return internal::sorted_quantile(samples, q);
+    });
+    return res;
+  }
+  std::mt19937_64 rng(options.seed);
+  std::uniform_int_distribution<std::size_t> pick(0, samples.size() - 1);
+  std::vector<double> means(resamples), medians(resamples);
+  std::vector<double> resample(samples.size());
+  for (std::size_t r = 0; r < resamples; ++r) {
+    double s = 0;
+    for (double& x : resample) {
+      x = samples[pick(rng)];
+      s += x;
+    }
+    means[r] = s / resample.size();
+    medians[r] = internal::select_median(resample);
+  }
+  std::sort(means.begin(), means.end());
+  std::sort(medians.begin(), medians.end());
+  double alpha = 1 - options.confidence;
+  res.mean_ci = Interval{internal::sorted_quantile(means, alpha / 2),
+                         internal::sorted_quantile(means, 1 - alpha / 2)};
+  res.median_ci = Interval{internal::sorted_quantile(medians, alpha / 2),
+                           internal::sorted_quantile(medians, 1 - alpha / 2)};
+  return res;
+}
+
+/* Summary of a sample stream. Order statistics are read off the histogram,
+ * so they carry its relative error. The mean interval uses the normal
+ * approximation and the median interval the binomial order-statistic
+ * bounds, as the samples needed for a bootstrap are not kept.
+ */
+inline Summary summarize(const StreamingStatistics& stats,
+                         const SummaryOptions& options = SummaryOptions()) {
+  if (stats.count() == 0) {
+    throw BenchmarkError("summarize: No samples.");
+  }
+  Summary res;
+  res.count = stats.count();
+  res.mean = stats.mean();
+  res.sum = stats.mean() * stats.count();
+  res.variance = stats.variance();
+  res.min = stats.min();
+  res.max = stats.max();
+  res.q1 = stats.quantile(0.25);
+  res.median = stats.quantile(0.5);
+  res.q3 = stats.quantile(0.75);
+  res.p90 = stats.quantile(0.9);
+  res.p99 = stats.quantile(0.99);
+  res.p999 = stats.quantile(0.999);
+
+  std::vector<std::pair<double, std::uint64_t>> deviations;
+  Outliers outliers = {0, 0, 0, 0};
+  double iqr = res.q3 - res.q1;
+  stats.histogram().for_each(
+    [&](std::int64_t lower, std::int64_t upper, std::uint64_t count) {
+      double x = (lower + upper) / 2.0;
+      deviations.push_back(std::make_pair(std::fabs(x - res.median), count));
+      if (x < res.q1 - 3 * iqr) outliers.low_severe += count;
+      else if (x < res.q1 - 1.5 * iqr) outliers.low_mild += count;
+      else if (x > res.q3 + 3 * iqr) outliers.high_severe += count;
+      else if (x > res.q3 + 1.5 * iqr) outliers.high_mild += count;
+    });
+  std::sort(deviations.begin(), deviations.end());
+  std::uint64_t seen = 0, half = (stats.count() + 1) / 2;
+  res.mad = 0;
+  for (const auto& d : deviations) {
+    seen += d.second;
+    if (seen >= half) {
+      res.mad = d.first;
+      break;
+    }
+  }
+  res.outliers = outliers;
+
+  internal::asymptotic_intervals(res, options.confidence, [&](double q) {
+    return stats.quantile(q);
+  });
+  return res;
+}
+
+/* Two-sided p-value of the Mann-Whitney U test that samples a and b come
+ * from the same distribution, using the normal approximation with tie and
+ * continuity corrections. Adequate from about ten samples per side.
+ */
+inline double mann_whitney_u(const std::vector<double>& a,
+                             const std::vector<double>& b) {
+  if (a.empty() || b.empty()) {
+    throw BenchmarkError("mann_whitney_u: No samples.");
+  }
+  std::vector<std::pair<double, bool>> pooled;
+  pooled.reserve(a.size() + b.size());
+  for (double x : a) pooled.push_back(std::make_pair(x, true));
+  for (double x : b) pooled.push_back(std::make_pair(x, false));
+  std::sort(pooled.begin(), pooled.end(),
+            [](const std::pair<double, bool>& l,
+               const std::pair<double, bool>& r) {
+              return l.first < r.first;
+            });
+  double rank_sum = 0, tie_term = 0;
+  for (std::size_t i = 0; i < pooled.size();) {
+    std::size_t j = i;
+    while (j < pooled.size() && pooled[j].first == pooled[i].first) ++j;
+    double rank = (i + 1 + j) / 2.0;
+    double ties = static_cast<double>(j - i);
+    tie_term += ties * ties * ties - ties;
+    for (std::size_t k = i; k < j; ++k) {
+      if (pooled[k].second) rank_sum += rank;
+    }
+    i = j;
+  }
+  double n1 = static_cast<double>(a.size());
+  double n2 = static_cast<double>(b.size());
+  double n = n1 + n2;
+  double u = rank_sum - n1 * (n1 + 1) / 2;
+  double mean = n1 * n2 / 2;
+  double variance = n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1)));
+  if (variance <= 0) return 1;
+  double z = std::max(0.0, std::fabs(u - mean) - 0.5) / std::sqrt(variance);
+  return std::erfc(z / std::sqrt(2.0));
+}
+
+/* Difference b - a of paired samples, such as repetitions of two variants
+ * run in the same rounds. Pairing cancels noise the two share, like drift
+ * between rounds, so small differences are resolved with fewer runs than
+ * an unpaired comparison needs.
+ */
+struct PairedDifference {
+  std::size_t count;
+  double mean;      // of b - a
+  double relative;  // mean / mean of a
+  Interval mean_ci;  // Student t interval of mean
+  double p_value;    // two-sided paired t-test of mean == 0
+};
+
+namespace internal {
+
+/* Regularized incomplete beta function I_x(a, b), by Lentz's continued
+ * fraction.
+ */
+inline double incomplete_beta(double a, double b, double x) {
+  if (x <= 0) return 0;
+  if (x >= 1) return 1;
+  if (x > (a + 1) / (a + b + 2)) return 1 - incomplete_beta(b, a, 1 - x);
+  const double tiny = 1e-300;
+  double front = std::exp(std::lgamma(a + b) - std::lgamma(a) -
+                          std::lgamma(b) + a * std::log(x) +
+                          b * std::log(1 - x)) / a;
+  double c = 1, d = 1 - (a + b) * x / (a + 1);
+  if (std::fabs(d) < tiny) d = tiny;
+  d = 1 / d;
+  double f = d;
+  for (int m = 1; m < 200; ++m) {
+    for (int step = 0; step < 2; ++step) {
+      double num = step == 0 ?
+        m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)) :
+        -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+      d = 1 + num * d;
+      if (std::fabs(d) < tiny) d = tiny;
+      c = 1 + num / c;
+      if (std::fabs(c) < tiny) c = tiny;
+      d = 1 / d;
+      f *= c * d;
+    }
+    if (std::fabs(c * d - 1) < 1e-12) break;
+  }
+  return front * f;
+}
+
+/* Two-sided tail probability of Student's t distribution.
+ */
+inline double student_t_p_value(double t, double df) {
+  return incomplete_beta(df / 2, 0.5, df / (df + t * t));
+}
+
+/* Two-sided Student t quantile for the given confidence, by bisection.
+ */
+inline double student_t_critical_value(double confidence, double df) {
+  double alpha = 1 - confidence;
+  double lo = 0, hi = 1000;
+  for (int i = 0; i < 100; ++i) {
+    double mid = (lo + hi) / 2;
+    if (student_t_p_value(mid, df) > alpha) lo = mid;
+    else hi = mid;
+  }
+  return (lo + hi) / 2;
+}
+
+}  // namespace internal
+
+inline PairedDifference paired_difference(const std::vector<double>& a,
+                                          const std::vector<double>& b,
+                                          double confidence = 0.95) {
+  if (a.size() != b.size()) {
+    throw BenchmarkError("paired_difference: Inconsistent sizes.");
+  }
+  if (a.size() < 2) {
+    throw BenchmarkError("paired_difference: Fewer than two pairs.");
+  }
+  double n = static_cast<double>(a.size());
+  double mean = 0, mean_a = 0, m2 = 0;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    double d = b[i] - a[i];
+    double delta = d - mean;
+    mean += delta / (i + 1);
+    m2 += delta * (d - mean);
+    mean_a += a[i] / n;
+  }
+  double standard_error = std::sqrt(m2 / (n - 1) / n);
+  double half_width =
+    internal::student_t_critical_value(confidence, n - 1) * standard_error;
+  PairedDifference res;
+  res.count = a.size();
+  res.mean = mean;
+  res.relative = mean_a != 0 ? mean / mean_a : 0;
+  res.mean_ci = Interval{mean - half_width, mean + half_width};
+  if (standard_error > 0) {
+    res.p_value = internal::student_t_p_value(mean / standard_error, n - 1);
+  } else {
+    res.p_value = mean == 0 ? 1 : 0;
+  }
+  return res;
+}
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_STATISTICS_H_
@@ -0,0 +1,38 @@
+// 2026-10-18
+// g++ -std=c++11 -O2 -pthread test_10.cc && ./a.out
+
+#include "benchmark.h"
+#include "compare.h"
+#include "reporter.h"
+
+using namespace benchmark;
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+void BM_nop(Timer& timer) {
+  while (timer.looping()) clobber_memory();
+}
+
+// Labels with quotes and backslashes survive JsonReporter and compare.
+void test_1() {
+  const std::string label = "say \"hi\"", item = "C:\\tmp\\\"x\"";
+  FunctionBenchmark<> bm(label);
+  bm.add(item, "ns", 100, BM_nop);
+  bm.run();
+  const std::string filename = "test_10.json";
+  JsonReporter(filename, false).report(bm);
+  std::vector<Comparison> res = compare(filename, filename);
+  std::remove(filename.c_str());
+  assert(res.size() == 1);
+  std::cout << res[0].benchmark << " / " << res[0].item << "\n";
+  assert(res[0].benchmark == label);
+  assert(res[0].item == item);
+}
+
+
+int main() {
+  test_1();
+}
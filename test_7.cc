@@ -0,0 +1,80 @@
+// 2026-10-18
+// g++ -std=c++11 -O2 -pthread test_7.cc && ./a.out
+// g++ -std=c++11 -O3 -pthread test_7.cc && ./a.out
+
+#include "benchmark.h"
+
+using namespace benchmark;
+
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+
+// A loop that survives optimization runs n iterations in at least
+// n * floor_ns, 100 iterations per ns being beyond any core even unrolled.
+// One that was optimized away only costs the clock reads of the timer.
+const double floor_ns = 0.01;
+const std::size_t n = 1 << 16;
+
+double mean_ns(const Timer& timer) {
+  return static_cast<double>(timer.duration().count()) / timer.iterations();
+}
+
+void test_1() {
+  Timer unguarded("unguarded", 100), guarded("guarded", 100);
+  while (unguarded.looping()) {
+    for (std::size_t i = 0; i < n; ++i) {
+      std::size_t x = i * i;
+      (void)x;
+    }
+  }
+  while (guarded.looping()) {
+    for (std::size_t i = 0; i < n; ++i) {
+      std::size_t x = i * i;
+      do_not_optimize(x);
+    }
+  }
+  std::cout << "do_not_optimize: " << mean_ns(unguarded) << " ns without, "
+            << mean_ns(guarded) << " ns with, floor " << n * floor_ns
+            << " ns\n";
+  assert(mean_ns(guarded) >= n * floor_ns);
+}
+
+void test_2() {
+  int value = 0;
+  int* p = &value;
+  do_not_optimize(p);
+  Timer unguarded("unguarded", 100), guarded("guarded", 100);
+  while (unguarded.looping()) {
+    for (std::size_t i = 0; i < n; ++i) *p = static_cast<int>(i);
+  }
+  while (guarded.looping()) {
+    for (std::size_t i = 0; i < n; ++i) {
+      *p = static_cast<int>(i);
+      clobber_memory();
+    }
+  }
+  std::cout << "clobber_memory: " << mean_ns(unguarded) << " ns without, "
+            << mean_ns(guarded) << " ns with, floor " << n * floor_ns
+            << " ns\n";
+  assert(mean_ns(guarded) >= n * floor_ns);
+  assert(value == static_cast<int>(n - 1));
+}
+
+void test_3() {
+  Timer timer("do_not_optimize(const&)", 100);
+  const std::size_t m = n;
+  while (timer.looping()) {
+    for (std::size_t i = 0; i < m; ++i) do_not_optimize(m + i);
+  }
+  std::cout << "do_not_optimize(const&): " << mean_ns(timer) << " ns, floor "
+            << n * floor_ns << " ns\n";
+  assert(mean_ns(timer) >= n * floor_ns);
+}
+
+
+int main() {
+  test_1();
+  test_2();
+  test_3();
+}
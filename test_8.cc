@@ -0,0 +1,56 @@
+// 2026-10-18
+// g++ -std=c++11 -O2 -pthread test_8.cc test_8_other.cc && ./a.out
+//
+// Benchmarks registered from two translation units that both include
+// every header, which links only if the headers define nothing twice.
+
+#include "allocation.h"
+#include "async.h"
+#include "benchmark.h"
+#include "binary_reporter.h"
+#include "cache.h"
+#include "clock.h"
+#include "compare.h"
+#include "complexity.h"
+#include "error.h"
+#include "experiment.h"
+#include "histogram.h"
+#include "json.h"
+#include "machine.h"
+#include "open_loop.h"
+#include "optimization.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include "registry.h"
+#include "reporter.h"
+#include "runner.h"
+#include "serialize.h"
+#include "statistics.h"
+#include "threading.h"
+#include "time_unit.h"
+#include "timer.h"
+#include "trace.h"
+
+using namespace benchmark;
+
+#include <cassert>
+#include <iostream>
+
+void BM_main(Timer& timer) {
+  while (timer.looping()) clobber_memory();
+}
+BENCHMARK(BM_main)->Unit("us");
+
+
+int main() {
+  RegisteredBenchmark bm("test_8");
+  bm.run();
+  bool main_item = false, other_item = false;
+  for (const Benchmark::Result& r : bm.result()) {
+    std::cout << r.label << "\t" << internal::time_unit_symbol(r.time_unit)
+              << "\n";
+    main_item = main_item || r.label == "BM_main";
+    other_item = other_item || r.label == "BM_other/64";
+  }
+  assert(main_item && other_item);
+}
@@ -0,0 +1,38 @@
+// 2026-10-18
+// The second translation unit of test_8.cc.
+
+#include "allocation.h"
+#include "async.h"
+#include "benchmark.h"
+#include "binary_reporter.h"
+#include "cache.h"
+#include "clock.h"
+#include "compare.h"
+#include "complexity.h"
+#include "error.h"
+#include "experiment.h"
+#include "histogram.h"
+#include "json.h"
+#include "machine.h"
+#include "open_loop.h"
+#include "optimization.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include "registry.h"
+#include "reporter.h"
+#include "runner.h"
+#include "serialize.h"
+#include "statistics.h"
+#include "threading.h"
+#include "time_unit.h"
+#include "timer.h"
+#include "trace.h"
+
+using namespace benchmark;
+
+void BM_other(Timer& timer, int n) {
+  while (timer.looping()) {
+    for (int i = 0; i < n; ++i) do_not_optimize(i);
+  }
+}
+BENCHMARK(BM_other)->Args(64)->Unit("ns");
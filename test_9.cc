@@ -0,0 +1,65 @@
+// 2026-10-18
+// g++ -std=c++11 -O2 -D_GLIBCXX_ASSERTIONS -pthread test_9.cc && ./a.out
+
+#include "benchmark.h"
+#include "complexity.h"
+
+using namespace benchmark;
+
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+void BM_sum(Timer& timer, std::size_t n) {
+  while (timer.looping()) {
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i) sum += i;
+    do_not_optimize(sum);
+  }
+}
+
+void test_1() {
+  FunctionBenchmark<std::size_t> bm("empty");
+  bool thrown = false;
+  try {
+    bm.add_range("r", "ns", 10, BM_sum, std::vector<std::size_t>{});
+  } catch (const BenchmarkError& e) {
+    std::cout << e.what() << "\n";
+    thrown = true;
+  }
+  assert(thrown);
+  bm.run();
+  assert(bm.result().empty());
+  assert(bm.complexity().empty());
+}
+
+void test_2() {
+  FunctionBenchmark<std::size_t> bm("zero");
+  bool thrown = false;
+  try {
+    bm.add_range("r", "ns", 10, BM_sum, std::vector<std::size_t>{0, 8, 64});
+  } catch (const BenchmarkError& e) {
+    std::cout << e.what() << "\n";
+    thrown = true;
+  }
+  assert(thrown);
+  assert(bm.result().empty());
+}
+
+void test_3() {
+  FunctionBenchmark<std::size_t> bm("linear");
+  bm.add_range("r", "ns", 100, BM_sum, range(1 << 10, 1 << 16));
+  bm.run();
+  std::vector<Benchmark::ComplexityResult> complexity = bm.complexity();
+  assert(complexity.size() == 1);
+  std::cout << complexity[0].label << ": "
+            << internal::big_o_symbol(complexity[0].fit.complexity) << "\n";
+}
+
+
+int main() {
+  test_1();
+  test_2();
+  test_3();
+}
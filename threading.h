@@ -0,0 +1,97 @@
+/* 2026-10-18 */
+#ifndef BENCHMARK_THREADING_H_
+#define BENCHMARK_THREADING_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "error.h"
+
+namespace benchmark {
+namespace internal {
+
+/* Reusable barrier for a fixed number of threads.
+ */
+class Barrier {
+public:
+  explicit Barrier(std::size_t count) :
+    count_(count), waiting_(0), generation_(0), mutex_(), cond_() {
+    if (count_ == 0) {
+      throw BenchmarkError("Barrier::Barrier: Count must be positive.");
+    }
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::size_t generation = generation_;
+    if (++waiting_ == count_) {
+      waiting_ = 0;
+      ++generation_;
+      cond_.notify_all();
+    } else {
+      cond_.wait(lock, [this, generation] {
+        return generation != generation_;
+      });
+    }
+  }
+
+private:
+  const std::size_t count_;
+  std::size_t waiting_;
+  std::size_t generation_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+};
+
+#ifdef __linux__
+/* The mask of the given CPUs, ignoring those out of range.
+ */
+inline cpu_set_t cpu_set(const std::vector<int>& cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  }
+  return set;
+}
+#endif
+
+/* Restricts the calling thread to the given CPUs. Returns false if the
+ * platform does not support it or the call fails.
+ */
+inline bool pin_current_thread(const std::vector<int>& cpus) {
+#ifdef __linux__
+  if (cpus.empty()) return false;
+  cpu_set_t set = cpu_set(cpus);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
+/* Restricts the calling process to the given CPUs, threads created later
+ * inherit the mask. Returns false on failure or if unsupported.
+ */
+inline bool pin_current_process(const std::vector<int>& cpus) {
+#ifdef __linux__
+  if (cpus.empty()) return false;
+  cpu_set_t set = cpu_set(cpus);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
+}  // namespace internal
+}  // namespace benchmark
+
+#endif  // BENCHMARK_THREADING_H_
@@ -11,7 +11,7 @@ typedef double TimeValue;
 
 namespace internal {
 
-std::string time_unit_symbol(TimeUnit unit) {
+inline std::string time_unit_symbol(TimeUnit unit) {
   switch (unit) {
     case ns: return "ns"; break;
     case us: return "us"; break;
@@ -21,7 +21,7 @@ std::string time_unit_symbol(TimeUnit unit) {
   }
 }
 
-TimeUnit to_time_unit(const std::string& symbol) {
+inline TimeUnit to_time_unit(const std::string& symbol) {
   if (symbol == "ns") return TimeUnit::ns;
   else if (symbol == "us") return TimeUnit::us;
   else if (symbol == "ms") return TimeUnit::ms;
@@ -29,11 +29,11 @@ TimeUnit to_time_unit(const std::string& symbol) {
   else return TimeUnit::unknown;
 }
 
-TimeValue multiplier[5][5] = {{   1, 1e-3, 1e-6, 1e-9, 1},
-                              { 1e3,    1, 1e-3, 1e-6, 1},
-                              { 1e6,  1e3,    1, 1e-3, 1},
-                              { 1e9,  1e6,  1e3,    1, 1},
-                              {   1,    1,    1,    1, 1}};
+static const TimeValue multiplier[5][5] = {{   1, 1e-3, 1e-6, 1e-9, 1},
+                                           { 1e3,    1, 1e-3, 1e-6, 1},
+                                           { 1e6,  1e3,    1, 1e-3, 1},
+                                           { 1e9,  1e6,  1e3,    1, 1},
+                                           {   1,    1,    1,    1, 1}};
 
 template <typename TimeValue1>
 TimeValue convert_time(TimeUnit unit_1, TimeUnit unit_2, TimeValue1 t) {
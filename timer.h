@@ -3,57 +3,156 @@
 #define BENCHMARK_TIMER_H_
 
 #include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "allocation.h"
+#include "cache.h"
+#include "clock.h"
 #include "error.h"
+#include "histogram.h"
+#include "optimization.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include "statistics.h"
+#include "threading.h"
 #include "time_unit.h"
 
 namespace benchmark {
-namespace internal {
-template <bool IsSteady = std::chrono::high_resolution_clock::is_steady>
-struct SteadyClock {
-  typedef std::chrono::high_resolution_clock type;
+
+/* User-defined counter. A rate counter is reported per second of measured
+ * time, otherwise its value is reported as is.
+ */
+struct Counter {
+  double value;
+  bool rate;
 };
-template <>
-struct SteadyClock<false> {
-  typedef std::chrono::steady_clock type;
+
+/* Receives samples while they are recorded, see Timer::set_sample_listener.
+ * Calls happen while the timer is paused, from the thread running it.
+ */
+class SampleListener {
+public:
+  virtual ~SampleListener() {}
+  /* Declares a source of samples, the returned id is passed back with each
+   * of its samples.
+   */
+  virtual std::uint32_t open_stream(const std::string& label) = 0;
+  /* ns is the mean duration of one iteration of the batch starting at
+   * iteration, with the fraction of a nanosecond kept.
+   */
+  virtual void on_sample(std::uint32_t stream, std::uint64_t iteration,
+                         std::uint32_t batch, double ns) = 0;
 };
-}  // namespace internal
 
-class Timer {
+/* Warmup that runs until the timings are steady: the median of the last
+ * window iterations differs from that of the window before by at most
+ * tolerance, relative to the earlier one. Stops at max_iterations anyway.
+ */
+struct AutoWarmup {
+  std::size_t window;
+  double tolerance;
+  std::size_t max_iterations;
+
+  AutoWarmup(std::size_t window_size = 10, double rel_tolerance = 0.05,
+             std::size_t max_iter = 10000) :
+    window(window_size == 0 ? 1 : window_size),
+    tolerance(rel_tolerance),
+    max_iterations(max_iter) {}
+};
+
+template <typename ClockPolicy = DefaultClock>
+class BasicTimer {
 public:
-  typedef internal::SteadyClock<>::type clock_type;
+  typedef ClockPolicy clock_type;
+  typedef typename clock_type::time_point time_point;
   typedef std::chrono::nanoseconds duration_type;
+  // Mean of one iteration in a batch, which need not be whole nanoseconds.
+  typedef std::chrono::duration<double, std::nano> sample_type;
   static constexpr const TimeUnit time_unit = TimeUnit::ns;
 
   const std::string label;
 
-  Timer(std::size_t iter = 1) : 
+  BasicTimer(std::size_t iter = 1) : 
     label("timer"),
     is_started_(false),
     is_stopped_(false),
     is_running_(false), 
     iterations_(iter),
     num_iterated_(0),
+    batch_size_(1),
+    current_batch_(1),
+    batch_settled_(true),
+    batch_begin_(0),
+    streaming_(false),
+    cache_mode_(CacheMode::warm),
+    warmup_count_(0),
+    auto_warmup_(false, AutoWarmup()),
+    warmup_done_(false),
+    warming_(false),
+    warmup_start_(),
+    warmup_durations_(),
     start_time_(),
     duration_(0),
     old_duration_(0),
-    loop_durations_() {
+    cycles_(0),
+    perf_counters_(),
+    perf_values_(),
+    bytes_processed_(0),
+    items_processed_(0),
+    counters_(),
+    allocations_(),
+    allocation_start_(),
+    loop_durations_(),
+    statistics_(),
+    listener_(nullptr),
+    stream_(0),
+    profiling_(false),
+    start_barrier_(nullptr) {
     if (iterations_ == 0) iterations_ = 1;
   }
-  Timer(const std::string& timer_label, std::size_t iter = 1) :
+  BasicTimer(const std::string& timer_label, std::size_t iter = 1) :
     label(timer_label),
     is_started_(false),
     is_stopped_(false),
     is_running_(false), 
     iterations_(iter),
     num_iterated_(0),
+    batch_size_(1),
+    current_batch_(1),
+    batch_settled_(true),
+    batch_begin_(0),
+    streaming_(false),
+    cache_mode_(CacheMode::warm),
+    warmup_count_(0),
+    auto_warmup_(false, AutoWarmup()),
+    warmup_done_(false),
+    warming_(false),
+    warmup_start_(),
+    warmup_durations_(),
     start_time_(),
     duration_(0),
     old_duration_(0),
-    loop_durations_() {
+    cycles_(0),
+    perf_counters_(),
+    perf_values_(),
+    bytes_processed_(0),
+    items_processed_(0),
+    counters_(),
+    allocations_(),
+    allocation_start_(),
+    loop_durations_(),
+    statistics_(),
+    listener_(nullptr),
+    stream_(0),
+    profiling_(false),
+    start_barrier_(nullptr) {
     if (iterations_ == 0) iterations_ = 1;
   }
 
@@ -65,8 +164,18 @@ public:
     if (!(!is_started_ && !is_stopped_ && !is_running_)) {
       throw BenchmarkError("Timer::start: Invalid pre-condition.");
     }
+    if (start_barrier_) {
+      start_barrier_->wait();
+      start_barrier_ = nullptr;
+    }
     is_started_ = true;
     is_running_ = true;
+    if (perf_counters_) {
+      perf_counters_->reset();
+      perf_counters_->enable();
+    }
+    allocation_start_ = internal::thread_allocation_counts();
+    if (profiling_) internal::profiled_thread() = 1;
     start_time_ = clock_type::now();
   }
 
@@ -74,16 +183,22 @@ public:
    *                is_stopped_ == false
    */
   void stop() {
-    clock_type::time_point stop_time_point = clock_type::now();
+    time_point stop_time_point = clock_type::now_end();
     if (!(is_started_ && !is_stopped_)) {
       throw BenchmarkError("Timer::stop: Invalid pre-condition.");
     }
     if (is_running_) {
-      duration_ += std::chrono::duration_cast<duration_type>
-                   (stop_time_point - start_time_);
+      if (profiling_) internal::profiled_thread() = 0;
+      duration_ += clock_type::nanoseconds(start_time_, stop_time_point);
+      cycles_ += clock_type::cycles(start_time_, stop_time_point);
+      allocations_ += internal::thread_allocation_counts() - allocation_start_;
       is_running_ = false;
     }
     is_stopped_ = true;
+    if (perf_counters_) {
+      perf_counters_->disable();
+      perf_values_ = perf_counters_->read();
+    }
   }
 
   /* Pre-condition: is_started_ == true and 
@@ -91,13 +206,16 @@ public:
    *                is_running_ == true
    */
   void pause() {
-    clock_type::time_point pause_time_point = clock_type::now();
+    time_point pause_time_point = clock_type::now_end();
     if (!(is_started_ && !is_stopped_ && is_running_)) {
       throw BenchmarkError("Timer::pause: Invalid pre-condition.");
     }
-    duration_ += std::chrono::duration_cast<duration_type>
-                 (pause_time_point - start_time_);
+    if (profiling_) internal::profiled_thread() = 0;
+    duration_ += clock_type::nanoseconds(start_time_, pause_time_point);
+    cycles_ += clock_type::cycles(start_time_, pause_time_point);
+    allocations_ += internal::thread_allocation_counts() - allocation_start_;
     is_running_ = false;
+    if (perf_counters_) perf_counters_->disable();
   }
 
   /* Pre-condition: is_started_ == true and 
@@ -109,15 +227,165 @@ public:
       throw BenchmarkError("Timer::resume: Invalid pre-condition.");
     }
     is_running_ = true;
+    if (perf_counters_) perf_counters_->enable();
+    allocation_start_ = internal::thread_allocation_counts();
+    if (profiling_) internal::profiled_thread() = 1;
     start_time_ = clock_type::now();
   }
 
+  /* Sets the number of iterations timed together as one sample, 0 picks it
+   * automatically so that a sample lasts at least auto_batch_duration.
+   * Samples hold the mean duration of one iteration in the batch. With 0,
+   * the batches taken while the size still grows are not recorded, except
+   * the last one of a run that ends before the size settles.
+   * Pre-condition: is_started_ == false
+   */
+  void set_batch_size(std::size_t batch) {
+    if (!(!is_started_)) {
+      throw BenchmarkError("Timer::set_batch_size: Invalid pre-condition.");
+    }
+    batch_size_ = batch;
+    current_batch_ = batch == 0 ? 1 : batch;
+    batch_settled_ = batch != 0;
+  }
+  inline std::size_t batch_size() const { return batch_size_; }
+
+  /* In streaming mode samples are folded into statistics() instead of being
+   * stored, so durations() stays empty and memory use does not grow with
+   * the number of iterations.
+   * Pre-condition: is_started_ == false
+   */
+  void set_streaming(bool enable) {
+    if (!(!is_started_)) {
+      throw BenchmarkError("Timer::set_streaming: Invalid pre-condition.");
+    }
+    streaming_ = enable;
+  }
+  inline bool streaming() const { return streaming_; }
+
+  /* In cold mode the last-level cache is evicted before every batch, while
+   * the timer is paused, so each sample starts from memory. With batches
+   * of one that is every iteration.
+   * Pre-condition: is_started_ == false
+   */
+  void set_cache_mode(CacheMode mode) {
+    if (!(!is_started_)) {
+      throw BenchmarkError("Timer::set_cache_mode: Invalid pre-condition.");
+    }
+    if (mode == CacheMode::cold) internal::cache_evictor();
+    cache_mode_ = mode;
+  }
+  inline CacheMode cache_mode() const { return cache_mode_; }
+
+  /* Runs n iterations before the measured ones. Each is timed on its own
+   * into warmup_durations() and left out of durations, statistics and
+   * every total.
+   * Pre-condition: is_started_ == false
+   */
+  void set_warmup(std::size_t n) {
+    if (!(!is_started_)) {
+      throw BenchmarkError("Timer::set_warmup: Invalid pre-condition.");
+    }
+    warmup_count_ = n;
+    auto_warmup_.first = false;
+  }
+  /* Warms up until the timings are steady, see AutoWarmup.
+   * Pre-condition: is_started_ == false
+   */
+  void set_warmup(const AutoWarmup& policy) {
+    if (!(!is_started_)) {
+      throw BenchmarkError("Timer::set_warmup: Invalid pre-condition.");
+    }
+    auto_warmup_ = std::pair<bool, AutoWarmup>(true, policy);
+  }
+  /* Warmup iterations of the current run.
+   */
+  inline std::size_t warmup_iterations() const {
+    return warmup_durations_.size();
+  }
+  std::vector<duration_type> warmup_durations() const {
+    return warmup_durations_;
+  }
+
+  /* Opens a perf_event counter group for the calling thread, which is then
+   * counted whenever the timer runs. If perf is unavailable the timer works
+   * as usual and perf_counters() reports no counters.
+   * Pre-condition: is_started_ == false
+   */
+  void set_perf_counters(bool enable) {
+    if (!(!is_started_)) {
+      throw BenchmarkError("Timer::set_perf_counters: Invalid pre-condition.");
+    }
+    if (!enable) perf_counters_.reset();
+    else if (!perf_counters_) perf_counters_ = std::make_shared<PerfCounters>();
+  }
+  inline const PerfCounters* perf_counter_group() const {
+    return perf_counters_.get();
+  }
+
+  /* Marks the running timer's thread for a running Profiler, which then
+   * samples it only while the timer runs.
+   * Pre-condition: is_started_ == false
+   */
+  void set_profiling(bool enable) {
+    if (!(!is_started_)) {
+      throw BenchmarkError("Timer::set_profiling: Invalid pre-condition.");
+    }
+    profiling_ = enable;
+  }
+  inline bool profiling() const { return profiling_; }
+
+  /* Makes the next start() wait on barrier, which threads timed together
+   * share so that their measurements begin at once, after each thread's
+   * warmup. The barrier is not owned, nullptr removes it.
+   * Pre-condition: is_started_ == false
+   */
+  void set_start_barrier(internal::Barrier* barrier) {
+    if (!(!is_started_)) {
+      throw BenchmarkError("Timer::set_start_barrier: Invalid pre-condition.");
+    }
+    start_barrier_ = barrier;
+  }
+  inline bool started() const { return is_started_; }
+
+  /* Forwards every sample to listener as it is recorded, nullptr stops
+   * forwarding. Combined with streaming mode no sample is kept in memory.
+   * The listener is not owned and has to outlive the run.
+   * Pre-condition: is_started_ == false
+   */
+  void set_sample_listener(SampleListener* listener, std::uint32_t stream) {
+    if (!(!is_started_)) {
+      throw BenchmarkError(
+        "Timer::set_sample_listener: Invalid pre-condition.");
+    }
+    listener_ = listener;
+    stream_ = stream;
+  }
+  void set_sample_listener(SampleListener* listener) {
+    set_sample_listener(listener, listener ? listener->open_stream(label) : 0);
+  }
+  inline SampleListener* sample_listener() const { return listener_; }
+  inline std::uint32_t sample_stream() const { return stream_; }
+
+  /* Each call is a compiler memory barrier, so stores of one iteration
+   * cannot be merged with or sunk past those of the next. Values that are
+   * only held in registers still need do_not_optimize.
+   */
   bool looping() {
+    clobber_memory();
+    if (num_iterated_ != 0 && !is_stopped_ &&
+        num_iterated_ - batch_begin_ < current_batch_ &&
+        num_iterated_ < iterations_) {
+      ++num_iterated_;
+      return true;
+    }
+    if (num_iterated_ == 0 && !warmup_done_ && warmup_looping()) return true;
     bool was_running = is_running_;
     if (is_started_ && !is_stopped_ && is_running_) pause();
     if (num_iterated_ != 0) {
-      loop_durations_.push_back(duration_ - old_duration_);
+      record_batch(duration_ - old_duration_, num_iterated_ - batch_begin_);
       old_duration_ = duration_;
+      batch_begin_ = num_iterated_;
     }
     if (is_stopped_) return false;
     if (num_iterated_ >= iterations_) {
@@ -131,6 +399,7 @@ public:
       old_duration_ = duration_;
     }    
     ++num_iterated_;
+    if (cache_mode_ == CacheMode::cold) internal::cache_evictor().evict();
     if (was_running) resume();
     return true;
   }
@@ -141,10 +410,23 @@ public:
     is_running_ = false;
     iterations_ = iter;
     num_iterated_ = 0;
-    start_time_ = clock_type::time_point();
+    current_batch_ = batch_size_ == 0 ? 1 : batch_size_;
+    batch_settled_ = batch_size_ != 0;
+    batch_begin_ = 0;
+    warmup_done_ = false;
+    warming_ = false;
+    warmup_durations_.clear();
+    start_time_ = time_point();
     duration_ = duration_type(0);
     old_duration_ = duration_type(0),
+    cycles_ = 0;
+    perf_values_ = PerfCounterValues();
+    bytes_processed_ = 0;
+    items_processed_ = 0;
+    counters_.clear();
+    allocations_ = AllocationCounts();
     loop_durations_.clear();
+    statistics_.clear();
   }
   void reset() { reset(iterations_); }
 
@@ -157,6 +439,69 @@ public:
     }
     return duration_;
   }
+  /* Elapsed CPU cycles, 0 unless clock_type is a cycle counter.
+   * Pre-condition: is_running_ == false
+   */
+  std::uint64_t cycles() const {
+    if (!(!is_running_)) {
+      throw BenchmarkError("Timer::cycles: "
+            "Cannot get cycles while the timer is still running.");
+    }
+    return cycles_;
+  }
+  /* Counter totals over the timed regions, read when the timer stops.
+   * Pre-condition: is_running_ == false
+   */
+  const PerfCounterValues& perf_counters() const {
+    if (!(!is_running_)) {
+      throw BenchmarkError("Timer::perf_counters: "
+            "Cannot get counters while the timer is still running.");
+    }
+    return perf_values_;
+  }
+  /* Work done by the whole run, reported as bytes and items per second of
+   * measured time. Usually set by the benchmark body after its loop.
+   */
+  void set_bytes_processed(std::uint64_t bytes) { bytes_processed_ = bytes; }
+  void set_items_processed(std::uint64_t items) { items_processed_ = items; }
+  inline std::uint64_t bytes_processed() const { return bytes_processed_; }
+  inline std::uint64_t items_processed() const { return items_processed_; }
+
+  void set_counter(const std::string& name, double value, bool rate = false) {
+    counters_[name] = Counter{value, rate};
+  }
+  inline const std::map<std::string, Counter>& counters() const {
+    return counters_;
+  }
+
+  /* Heap allocations of the calling thread while the timer ran, all 0
+   * unless allocation_tracking_enabled().
+   * Pre-condition: is_running_ == false
+   */
+  const AllocationCounts& allocations() const {
+    if (!(!is_running_)) {
+      throw BenchmarkError("Timer::allocations: "
+            "Cannot get allocations while the timer is still running.");
+    }
+    return allocations_;
+  }
+  /* Throws if the timed part of the run allocated, or if allocations are
+   * not tracked at all. Meant to be called after the loop of a benchmark
+   * body whose hot path must not touch the heap.
+   * Pre-condition: is_running_ == false
+   */
+  void assert_no_allocations() const {
+    if (!allocation_tracking_enabled()) {
+      throw BenchmarkError("Timer::assert_no_allocations: "
+            "Allocation tracking is not enabled.");
+    }
+    if (allocations().allocations != 0) {
+      throw BenchmarkError("Timer::assert_no_allocations: " +
+            std::to_string(allocations_.allocations) + " allocations in \"" +
+            label + "\".");
+    }
+  }
+
   inline std::size_t iterations() const { return iterations_; }
   inline std::size_t iter_index() const {
     return num_iterated_ == 0 ? 0 : num_iterated_ - 1;
@@ -164,29 +509,139 @@ public:
 
   /* Pre-condition: is_running_ = false
    */
-  std::vector<duration_type> durations() const {
+  std::vector<sample_type> durations() const {
     if (!(!is_running_)) {
       throw BenchmarkError("Timer::loop_durations: "
             "Cannot get loop durations while the timer is still running.");
     }
-    if (iterations_ == 1) return std::vector<duration_type>{duration_};
+    if (iterations_ == 1 && !streaming_) {
+      return std::vector<sample_type>{duration_};
+    }
     return loop_durations_;
   }
 
+  /* Pre-condition: is_running_ == false
+   */
+  const StreamingStatistics& statistics() const {
+    if (!(!is_running_)) {
+      throw BenchmarkError("Timer::statistics: "
+            "Cannot get statistics while the timer is still running.");
+    }
+    return statistics_;
+  }
+
 private:
+  static constexpr const std::int64_t auto_batch_duration = 2000;  // ns
+
+  /* Ends the warmup iteration in flight, if any, and starts the next one
+   * unless the warmup is over.
+   */
+  bool warmup_looping() {
+    time_point now = clock_type::now_end();
+    if (warming_) {
+      warmup_durations_.push_back(clock_type::nanoseconds(warmup_start_, now));
+    }
+    warming_ = warmup_continues();
+    if (!warming_) {
+      warmup_done_ = true;
+      return false;
+    }
+    if (cache_mode_ == CacheMode::cold) internal::cache_evictor().evict();
+    warmup_start_ = clock_type::now();
+    return true;
+  }
+
+  bool warmup_continues() const {
+    std::size_t n = warmup_durations_.size();
+    if (!auto_warmup_.first) return n < warmup_count_;
+    const AutoWarmup& policy = auto_warmup_.second;
+    if (n >= policy.max_iterations) return false;
+    if (n < 2 * policy.window) return true;
+    std::vector<double> previous, last;
+    for (std::size_t i = n - 2 * policy.window; i < n - policy.window; ++i) {
+      previous.push_back(warmup_durations_[i].count());
+      last.push_back(warmup_durations_[i + policy.window].count());
+    }
+    double previous_median = internal::select_median(previous);
+    double last_median = internal::select_median(last);
+    return std::fabs(last_median - previous_median) >
+           policy.tolerance * previous_median;
+  }
+
+  void record_batch(duration_type batch_duration, std::size_t batch) {
+    if (batch == 0) batch = 1;
+    if (!batch_settled_) {
+      if (batch == current_batch_ &&
+          batch_duration.count() < auto_batch_duration) {
+        current_batch_ *= 2;
+        if (!is_stopped_ && num_iterated_ < iterations_) return;
+      } else {
+        batch_settled_ = true;
+      }
+    }
+    sample_type mean = sample_type(batch_duration) / batch;
+    if (streaming_) {
+      statistics_.add(mean.count());
+    } else {
+      loop_durations_.push_back(mean);
+    }
+    if (listener_) {
+      listener_->on_sample(stream_, batch_begin_,
+                           static_cast<std::uint32_t>(batch), mean.count());
+    }
+  }
+
   bool is_started_;
   bool is_stopped_;
   bool is_running_;
 
   std::size_t iterations_;
   std::size_t num_iterated_;
+  std::size_t batch_size_;
+  std::size_t current_batch_;
+  bool batch_settled_;  // current_batch_ no longer grows
+  std::size_t batch_begin_;  // num_iterated_ at the start of the batch
+  bool streaming_;
+  CacheMode cache_mode_;
+  std::size_t warmup_count_;
+  std::pair<bool, AutoWarmup> auto_warmup_;
+  bool warmup_done_;
+  bool warming_;  // a warmup iteration is in flight
+  time_point warmup_start_;
+  std::vector<duration_type> warmup_durations_;
 
-  clock_type::time_point start_time_;
+  time_point start_time_;
   duration_type duration_;
   duration_type old_duration_;  // duration_ in the last looping statement
-  std::vector<duration_type> loop_durations_;
+  std::uint64_t cycles_;
+  std::shared_ptr<PerfCounters> perf_counters_;
+  PerfCounterValues perf_values_;
+  std::uint64_t bytes_processed_;
+  std::uint64_t items_processed_;
+  std::map<std::string, Counter> counters_;
+  AllocationCounts allocations_;
+  AllocationCounts allocation_start_;  // thread totals when last resumed
+  std::vector<sample_type> loop_durations_;
+  StreamingStatistics statistics_;
+  SampleListener* listener_;
+  std::uint32_t stream_;
+  bool profiling_;
+  internal::Barrier* start_barrier_;
 };
 
+#ifdef BENCHMARK_USE_TSC
+#ifndef BENCHMARK_HAS_TSC
+#error "BENCHMARK_USE_TSC requires an x86 time stamp counter."
+#endif
+typedef BasicTimer<TscClock> Timer;
+#else
+typedef BasicTimer<> Timer;
+#endif
+
+#ifdef BENCHMARK_HAS_TSC
+typedef BasicTimer<TscClock> CycleTimer;
+#endif
+
 }  // namespace benchmark
 
 #endif  // BENCHMARK_TIMER_H_